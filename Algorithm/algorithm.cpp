@@ -10,6 +10,15 @@
 #include <cassert>
 #include <iterator>
 #include <random>
+#include <numeric>
+#include <thread>
+
+#include "parallel_algorithm.h"
+#include "simd_search.h"
+#include "radix_sort.h"
+#include "sorted_sets.h"
+#include "substring_search.h"
+#include "../Threading/thread_pool.h"
 
 
 template <typename T>
@@ -97,6 +106,30 @@ int main(void)
         std::cout << "First instance is " << *position << " (offset of " << std::distance(source.cbegin(), position) << ")" <<  std::endl;
     }
 
+    //Searcher, Horspool, TwoWay and AhoCorasick, against std::search and std::find_end
+    for (auto level: {SimdLevel::Scalar, SimdLevel::Sse42, SimdLevel::Avx2})
+    {
+        std::string source{"Kalamazoo"};
+        auto first = source.data();
+        auto last = first + source.size();
+        assert(4 == Searcher("maz", level).Find(first, last) - first);
+        assert(5 == Searcher("a", level).FindLast(first, last) - first);
+        assert(last == Searcher("zoom", level).Find(first, last));
+        assert(first == Searcher("", level).Find(first, last));
+
+        std::string ref{"ama"};
+        assert(std::search(first, last, std::cbegin(ref), std::cend(ref)) == Horspool(ref.data(), ref.data() + ref.size()).Find(first, last));
+        assert(std::search(first, last, std::cbegin(ref), std::cend(ref)) == TwoWay(ref.data(), ref.data() + ref.size()).Find(first, last));
+        assert(std::find_end(first, last, std::cbegin(ref), std::cend(ref)) ==
+               Horspool(ref.data(), ref.data() + ref.size()).FindLast(first, last));
+
+        std::vector<std::pair<size_t, size_t>> matches;
+        AhoCorasick{{"ala", "amaz", "ma", "zoo"}}.ForEachMatch(first, last, [&](size_t pattern, size_t offset) {
+            matches.emplace_back(pattern, offset);
+        });
+        assert((std::vector<std::pair<size_t, size_t>>{{0, 1}, {2, 4}, {1, 3}, {3, 6}} == matches));
+    }
+
     //std::copy_if
     {
         std::vector<double> dest;
@@ -312,8 +345,270 @@ int main(void)
         assert(exp == result);
     }
 
+    //SortedSets, the same results as the std set operations, and galloping once one list is much longer
+    {
+        std::vector<int> r1 = {1,2,3,6,8,22};
+        std::vector<int> r2 = {1,2,4,6,9,22};
+        std::vector<int> sorted(20 * SortedSets::GallopRatio);
+        std::iota(std::begin(sorted), std::end(sorted), 0);
+        decltype(sorted) sub = {1,5,6};
 
+        decltype(r2) result;
+        SortedSets::Intersection(std::cbegin(r1), std::cend(r1), std::cbegin(r2), std::cend(r2), std::back_inserter(result));
+        assert((std::vector<int>{1,2,6,22} == result));
+
+        result.clear();
+        SortedSets::SymmetricDifference(std::cbegin(r1), std::cend(r1), std::cbegin(r2), std::cend(r2), std::back_inserter(result));
+        assert((std::vector<int>{3,4,8,9} == result));
+
+        assert(SortedSets::Includes(std::cbegin(sorted), std::cend(sorted), std::cbegin(sub), std::cend(sub)));
+        result.clear();
+        SortedSets::Difference(std::cbegin(sorted), std::cend(sorted), std::cbegin(sub), std::cend(sub), std::back_inserter(result));
+        assert(sorted.size() - 3 == result.size());
+        assert(!SortedSets::Includes(std::cbegin(result), std::cend(result), std::cbegin(sub), std::cend(sub)));
+
+        result.clear();
+        SortedSets::Intersection(std::cbegin(sub), std::cend(sub), std::cbegin(sorted), std::cend(sorted), std::back_inserter(result));
+        assert(sub == result);
+        result.clear();
+        SortedSets::Union(std::cbegin(sub), std::cend(sub), std::cbegin(sorted), std::cend(sorted), std::back_inserter(result));
+        assert(sorted == result);
+
+        using It = std::vector<int>::const_iterator;
+        result.clear();
+        SortedSets::IntersectAll(std::vector<std::pair<It, It>>{{std::cbegin(sorted), std::cend(sorted)}, {std::cbegin(r1), std::cend(r1)},
+                                                                {std::cbegin(r2), std::cend(r2)}}, std::back_inserter(result));
+        assert((std::vector<int>{1,2,6,22} == result));
+    }
 
+    //SortedSets::Intersection of similar 32 bit lists (the AVX2 path) with values repeated a lot, a little and not at all
+    {
+        std::mt19937 rng{7};
+        for (uint32_t spread: {4U, 64U, 1024U, 1U << 30})
+        {
+            for (size_t size: {64, 65, 200, 1000})
+            {
+                std::vector<uint32_t> lhs(size);
+                std::vector<uint32_t> rhs(size - size / 4);
+                std::generate(lhs.begin(), lhs.end(), [&]{return rng() % spread;});
+                std::generate(rhs.begin(), rhs.end(), [&]{return rng() % spread;});
+                std::sort(lhs.begin(), lhs.end());
+                std::sort(rhs.begin(), rhs.end());
+
+                std::vector<uint32_t> expected;
+                std::set_intersection(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), std::back_inserter(expected));
+                std::vector<uint32_t> result;
+                SortedSets::Intersection(lhs.cbegin(), lhs.cend(), rhs.cbegin(), rhs.cend(), std::back_inserter(result));
+                assert(expected == result);
+                result.clear();
+                SortedSets::Intersection(rhs.cbegin(), rhs.cend(), lhs.cbegin(), lhs.cend(), std::back_inserter(result));
+                assert(expected == result);
+            }
+        }
+    }
+
+    //the SimdSearch kernels at every level, against the std versions above
+    for (auto level: {SimdLevel::Scalar, SimdLevel::Sse42, SimdLevel::Avx2})
+    {
+        std::string source{"Kalamazoo"};
+        std::string ref{"lzo"};
+        auto first = source.data();
+        auto last = first + source.size();
+        assert(2 == SimdSearch::FindFirstOf(first, last, ref.data(), ref.data() + ref.size(), level) - first);
+        assert(7 == SimdSearch::AdjacentFind(first, last, level) - first);
+        assert(first + 7 == SimdSearch::AdjacentFind(first, first + 7, level));
+
+        std::string longer(100, 'a');
+        longer += source;
+        assert(std::find_first_of(longer.cbegin(), longer.cend(), ref.cbegin(), ref.cend()) - longer.cbegin() ==
+               SimdSearch::FindFirstOf(longer.data(), longer.data() + longer.size(), ByteSet{"lzo"}, level) - longer.data());
+        assert(0 == SimdSearch::AdjacentFind(longer.data(), longer.data() + longer.size(), level) - longer.data());
+
+        std::vector<int> values(40);
+        std::iota(std::begin(values), std::end(values), 0);
+        auto valuesRef = values;
+        valuesRef[33] = -1;
+        auto result = SimdSearch::Mismatch(values.data(), values.data() + values.size(), valuesRef.data(), valuesRef.data() + valuesRef.size(), level);
+        assert(33 == result.first - values.data() && 33 == result.second - valuesRef.data());
+
+        auto min{2.0f};
+        auto max{4.0f};
+        assert(std::count_if(std::cbegin(work), std::cend(work), [&](auto value){ return value < max && value > min;}) ==
+               long(SimdSearch::CountInRange(work.data(), work.data() + work.size(), min, max, level)));
+    }
+
+    //the parallel versions, with a grain of 1 so even these short vectors are split over the pool
+    {
+        ThreadPool pool{std::max(2U, std::thread::hardware_concurrency())};
+        pool.Start();
+        ParallelPolicy policy{pool, 1};
+
+        //Parallel::ForEach
+        {
+            std::vector<int> ref(20, 1);
+            Parallel::ForEach(policy, std::begin(ref), std::end(ref), [](auto& value){value *= 3;});
+            assert(std::count(std::cbegin(ref), std::cend(ref), 3) == 20);
+        }
+
+        //Parallel::AllOf, Parallel::AnyOf, Parallel::NoneOf
+        {
+            ref = 0.5f;
+            assert(!Parallel::AllOf(policy, std::cbegin(work), std::cend(work), lt));
+            assert(Parallel::AllOf(policy, std::cbegin(work), std::cend(work), gt));
+            ref = 3.0f;
+            assert(Parallel::AnyOf(policy, std::cbegin(work), std::cend(work), gt));
+            ref = 8.0f;
+            assert(!Parallel::AnyOf(policy, std::cbegin(work), std::cend(work), gt));
+            assert(Parallel::NoneOf(policy, std::cbegin(work), std::cend(work), gt));
+        }
+
+        //Parallel::CountIf
+        {
+            ref = 4.0f;
+            assert(size_t{2} == Parallel::CountIf(policy, std::cbegin(work), std::cend(work), gt));
+            assert(size_t(std::count_if(std::cbegin(work), std::cend(work), gt)) == Parallel::CountIf(policy, std::cbegin(work), std::cend(work), gt));
+        }
+
+        //Parallel::CopyIf
+        {
+            std::vector<double> dest(work.size());
+            auto tail = Parallel::CopyIf(policy, std::cbegin(work), std::cend(work), std::begin(dest), [](auto value){return value >= 2.0f && value <= 4.0f;});
+            dest.erase(tail, dest.end());
+            assert(size_t{3} == dest.size());
+            assert(std::is_sorted(std::cbegin(dest), std::cend(dest)));
+        }
+
+        //Parallel::Transform
+        {
+            std::vector<int> ref{1,2,3,4,5};
+            std::vector<int> result(ref.size());
+
+            Parallel::Transform(policy, std::cbegin(ref), std::cend(ref), std::begin(result), doubleIt);
+
+            assert(std::equal(std::cbegin(ref), std::cend(ref), std::cbegin(result), isDouble));
+        }
+
+        //Parallel::RemoveIf
+        {
+            std::vector<int> ref(20);
+            std::iota(std::begin(ref), std::end(ref), 0);
+            auto tail = Parallel::RemoveIf(policy, std::begin(ref), std::end(ref), isOdd);
+            ref.erase(tail, ref.end());
+            assert(size_t{10} == ref.size());
+            assert(std::none_of(std::cbegin(ref), std::cend(ref), isOdd));
+            assert(std::is_sorted(std::cbegin(ref), std::cend(ref)));
+        }
+
+        //Parallel::Partition
+        {
+            std::vector<int> ref(20);
+            std::iota(std::begin(ref), std::end(ref), 0);
+
+            auto boundary = Parallel::Partition(policy, std::begin(ref), std::end(ref), isEven);
+
+            assert(size_t{10} == std::distance(std::begin(ref), boundary));
+            assert(std::is_partitioned(std::cbegin(ref), std::cend(ref), isEven));
+            assert(boundary == std::partition_point(std::cbegin(ref), std::cend(ref), isEven));
+        }
+
+        //Parallel::Sort
+        {
+            std::vector<int> ref(20);
+            std::iota(std::begin(ref), std::end(ref), 0);
+            std::shuffle(std::begin(ref), std::end(ref), std::mt19937());
+
+            assert(!std::is_sorted(std::cbegin(ref), std::cend(ref)));
+            Parallel::Sort(policy, std::begin(ref), std::end(ref));
+            assert(std::is_sorted(std::cbegin(ref), std::cend(ref)));
+            assert(0 == ref.front() && 19 == ref.back());
+        }
+
+        //Parallel::StableSort
+        {
+            std::vector<std::pair<int, int>> ref(20);
+            std::generate(std::begin(ref), std::end(ref), [val=0]() mutable {auto temp=val++; return std::make_pair(temp % 4, temp);});
+            Parallel::StableSort(policy, std::begin(ref), std::end(ref), [](auto const& lhs, auto const& rhs){return lhs.first < rhs.first;});
+            assert(std::is_sorted(std::cbegin(ref), std::cend(ref)));
+        }
+
+        //RadixSort, signed keys and doubles (below SmallSort it only sorts on the keys, so make them big enough to
+        //take the radix passes)
+        {
+            std::vector<int> ref(5000);
+            std::iota(std::begin(ref), std::end(ref), -2500);
+            std::shuffle(std::begin(ref), std::end(ref), std::mt19937());
+            RadixSort::Sort(policy, std::begin(ref), std::end(ref));
+            assert(std::is_sorted(std::cbegin(ref), std::cend(ref)));
+            assert(-2500 == ref.front() && 2499 == ref.back());
+
+            std::vector<double> doubles(ref.size());
+            std::transform(std::cbegin(ref), std::cend(ref), std::begin(doubles), [](auto value){return value / 7.0;});
+            std::shuffle(std::begin(doubles), std::end(doubles), std::mt19937());
+            std::vector<int> order(doubles.size());
+            std::iota(std::begin(order), std::end(order), 0);
+            auto keys = doubles;
+            RadixSort::SortPairs(policy, std::begin(keys), std::end(keys), std::begin(order));
+            assert(std::is_sorted(std::cbegin(keys), std::cend(keys)));
+            assert(std::all_of(std::cbegin(order), std::cend(order), [&, idx=0](auto from) mutable {return doubles[from] == keys[idx++];}));
+        }
+
+        //Parallel::NthElement
+        {
+            std::vector<int> ref(20);
+            std::iota(std::begin(ref), std::end(ref), 0);
+            std::shuffle(std::begin(ref), std::end(ref), std::mt19937());
+
+            auto midIt = ref.begin()+10;
+            Parallel::NthElement(policy, std::begin(ref), midIt, std::end(ref));
+
+            assert(10 == *midIt);
+            assert(std::is_partitioned(std::cbegin(ref), std::cend(ref), [&](auto value){return value < *midIt;}));
+        }
+
+        //Parallel::Merge
+        {
+            std::vector<int> sorted(20);
+            std::iota(std::begin(sorted), std::end(sorted), 0);
+
+            std::vector<int> odd(10);
+            std::generate(std::begin(odd), std::end(odd), [val=1]() mutable {auto temp=val; val+=2; return temp;});
+            std::vector<int> even(10);
+            std::generate(std::begin(even), std::end(even), [val=0]() mutable {auto temp=val; val+=2; return temp;});
+
+            std::vector<int> result(odd.size() + even.size());
+            Parallel::Merge(policy, std::cbegin(odd), std::cend(odd), std::cbegin(even), std::cend(even), std::begin(result));
+
+            assert(std::equal(std::cbegin(result), std::cend(result), std::cbegin(sorted)));
+        }
+
+        //SortedSets, partitioned
+        {
+            std::vector<int> r1(100);
+            std::generate(std::begin(r1), std::end(r1), [val=0]() mutable {return val++ / 3;});
+            std::vector<int> r2 = {1,1,2,4,6,9,22,22,22,22,40};
+
+            std::vector<int> result;
+            SortedSets::Intersection(policy, std::cbegin(r1), std::cend(r1), std::cbegin(r2), std::cend(r2), std::back_inserter(result));
+            assert((std::vector<int>{1,1,2,4,6,9,22,22,22} == result));
+
+            std::vector<int> expected;
+            std::set_union(std::cbegin(r1), std::cend(r1), std::cbegin(r2), std::cend(r2), std::back_inserter(expected));
+            result.clear();
+            SortedSets::Union(policy, std::cbegin(r1), std::cend(r1), std::cbegin(r2), std::cend(r2), std::back_inserter(result));
+            assert(expected == result);
+        }
+
+        //TextSearch::FindAll, one block per byte, so every match crosses a block boundary
+        {
+            std::string source{"Kalamazoo, Kalamazoo"};
+            auto matches = TextSearch::FindAll(policy, source.data(), source.data() + source.size(), Searcher{"ama"});
+            assert((std::vector<TextMatch>{{3, 0}, {14, 0}} == matches));
+            matches = TextSearch::FindAll(policy, source.data(), source.data() + source.size(), AhoCorasick{{"zoo", "o"}});
+            assert((std::vector<TextMatch>{{6, 0}, {7, 1}, {8, 1}, {17, 0}, {18, 1}, {19, 1}} == matches));
+        }
+
+        pool.Stop();
+    }
 
     return 0;
 }
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <random>
+#include <iterator>
+#include <iostream>
+
+#include "../Threading/bench.h"
+
+/**
+ * Times the std algorithms algorithm.cpp walks through, on vectors big enough to leave the caches
+ */
+
+/**
+ * Takes the number of elements (default 10^7), and the options in bench.h
+ */
+int main(int argc, char* argv[])
+{
+    BenchSuite suite{"algorithm", argc, argv};
+    size_t count = suite.Arg(0, 10000000);
+
+    std::mt19937 rng{42};
+    std::vector<int> values(count);
+    std::generate(std::begin(values), std::end(values), [&]{return static_cast<int>(rng() % 1000000);});
+    std::vector<int> sorted{values};
+    std::sort(std::begin(sorted), std::end(sorted));
+    std::vector<int> otherSorted(count);
+    std::generate(std::begin(otherSorted), std::end(otherSorted), [&]{return static_cast<int>(rng() % 1000000);});
+    std::sort(std::begin(otherSorted), std::end(otherSorted));
+    std::vector<double> doubles(count);
+    std::generate(std::begin(doubles), std::end(doubles), [&]{return (rng() % 100000) / 10.0;});
+    std::vector<int> almostValues{values}; //differs from values in the last element only
+    almostValues.back() += 1;
+    std::string text(count, ' '); //random letters, no two neighbours equal until the very end
+    for (auto idx=0U; idx < count; ++idx)
+    {
+        do
+        {
+            text[idx] = static_cast<char>('a' + rng() % 26);
+        } while (idx != 0 && text[idx] == text[idx - 1]);
+    }
+    text.back() = text[count - 2];
+
+    auto isOdd = [](auto value) {return (value % 2) == 1;};
+    std::vector<int> work;
+    std::vector<int> out;
+    out.reserve(2 * count);
+    auto reset = [&]{work = values; out.clear();};
+
+    suite.Run("for_each", [&]{
+        long sum{0};
+        std::for_each(std::cbegin(values), std::cend(values), [&](auto value){sum += value;});
+        DoNotOptimize(sum);
+    }, count);
+    suite.Run("count_if", [&]{DoNotOptimize(std::count_if(std::cbegin(values), std::cend(values), isOdd));}, count);
+    suite.Run("all_of", [&]{DoNotOptimize(std::all_of(std::cbegin(values), std::cend(values), [](auto value){return value >= 0;}));}, count);
+    suite.Run("any_of", [&]{DoNotOptimize(std::any_of(std::cbegin(values), std::cend(values), [](auto value){return value < 0;}));}, count);
+    suite.Run("count_if/doubles_in_range", [&]{
+        DoNotOptimize(std::count_if(std::cbegin(doubles), std::cend(doubles), [](auto value){return value > 2000.0 && value < 4000.0;}));
+    }, count);
+    suite.RunWithSetup("transform", reset, [&]{
+        std::transform(std::cbegin(values), std::cend(values), std::begin(work), [](auto value){return value * 3 + 1;});
+        DoNotOptimize(work.back());
+    }, count);
+    suite.RunWithSetup("copy_if", reset, [&]{
+        std::copy_if(std::cbegin(values), std::cend(values), std::back_inserter(out), isOdd);
+        DoNotOptimize(out.size());
+    }, count);
+    suite.RunWithSetup("remove_if", reset, [&]{
+        work.erase(std::remove_if(std::begin(work), std::end(work), isOdd), std::end(work));
+        DoNotOptimize(work.size());
+    }, count);
+    suite.RunWithSetup("partition", reset, [&]{DoNotOptimize(std::partition(std::begin(work), std::end(work), isOdd));}, count);
+    suite.RunWithSetup("sort", reset, [&]{std::sort(std::begin(work), std::end(work));}, count);
+    suite.RunWithSetup("nth_element", reset, [&]{
+        std::nth_element(std::begin(work), std::begin(work) + count / 2, std::end(work));
+        DoNotOptimize(work[count / 2]);
+    }, count);
+    suite.RunWithSetup("merge", reset, [&]{
+        std::merge(std::cbegin(sorted), std::cend(sorted), std::cbegin(otherSorted), std::cend(otherSorted), std::back_inserter(out));
+        DoNotOptimize(out.size());
+    }, 2 * count);
+    suite.RunWithSetup("set_intersection", reset, [&]{
+        std::set_intersection(std::cbegin(sorted), std::cend(sorted), std::cbegin(otherSorted), std::cend(otherSorted), std::back_inserter(out));
+        DoNotOptimize(out.size());
+    }, 2 * count);
+    suite.Run("includes", [&]{
+        DoNotOptimize(std::includes(std::cbegin(sorted), std::cend(sorted), std::cbegin(sorted) + count / 2, std::cend(sorted)));
+    }, count);
+    suite.Run("mismatch", [&]{
+        DoNotOptimize(std::mismatch(std::cbegin(values), std::cend(values), std::cbegin(almostValues), std::cend(almostValues)).first);
+    }, count);
+    suite.Run("adjacent_find/text", [&]{
+        DoNotOptimize(std::adjacent_find(std::cbegin(text), std::cend(text)));
+    }, count);
+    std::string set{"#@!"};
+    suite.Run("find_first_of/text", [&]{
+        DoNotOptimize(std::find_first_of(std::cbegin(text), std::cend(text), std::cbegin(set), std::cend(set)));
+    }, count);
+    std::string needle{"kalamazoo"};
+    suite.Run("search/text", [&]{
+        DoNotOptimize(std::search(std::cbegin(text), std::cend(text), std::cbegin(needle), std::cend(needle)));
+    }, count);
+    suite.Run("find_end/text", [&]{
+        DoNotOptimize(std::find_end(std::cbegin(text), std::cend(text), std::cbegin(needle), std::cend(needle)));
+    }, count);
+    return suite.Finish();
+}
@@ -0,0 +1,441 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+/**
+ * Parallel versions of the std algorithms algorithm.cpp walks through, running on one of our ThreadPools instead of
+ * std::execution::par (which needs TBB). Each takes the same arguments as its std counterpart after a policy:
+ *
+ *     ThreadPool pool{threads};
+ *     pool.Start();
+ *     ParallelPolicy policy{pool};
+ *     auto odd = Parallel::CountIf(policy, values.begin(), values.end(), isOdd);
+ *     Parallel::Sort(policy, values.begin(), values.end());
+ *
+ * The ranges are cut into a few contiguous blocks per worker (never below the policy's grain), and every block is
+ * one ParallelFor index, so a call costs a handful of tasks and the blocks stream through memory. Iterators must be
+ * random access. Predicates and operations may be called from several threads at once and must not throw; like
+ * the std policies, the algorithms that reorder need default constructible values for their scratch buffers.
+ */
+
+/**
+ * Which pool to run on, and the smallest block worth handing to it. Pool needs ParallelFor and Threads().
+ */
+template <typename Pool>
+class ParallelPolicy
+{
+public:
+    static constexpr size_t DefaultGrain{16384};
+    static constexpr size_t BlocksPerThread{4};
+
+    ParallelPolicy() = delete;
+    explicit ParallelPolicy(Pool& pool, size_t grain = DefaultGrain) : m_pool(pool), m_grain{std::max<size_t>(grain, 1)} {}
+
+    /**
+     * How many blocks count elements are cut into, 1 when it isn't worth going parallel
+     */
+    size_t Blocks(size_t count) const
+    {
+        return std::clamp<size_t>(count / m_grain, 1, std::max<size_t>(m_pool.Threads(), 1) * BlocksPerThread);
+    }
+
+    /**
+     * body(idx) for every idx in [0, count), on the pool unless there is only one
+     */
+    template <typename Body>
+    void ForEachIndex(size_t count, Body body) const
+    {
+        if (count == 1)
+        {
+            body(0);
+            return;
+        }
+        m_pool.ParallelFor(0, count, 1, body);
+    }
+
+    /**
+     * body(block, lo, hi) for each of the Blocks(count) blocks [lo, hi) of [0, count)
+     */
+    template <typename Body>
+    void ForEachBlock(size_t count, Body body) const
+    {
+        auto blocks = Blocks(count);
+        ForEachIndex(blocks, [&](size_t block) {body(block, block * count / blocks, (block + 1) * count / blocks);});
+    }
+
+private:
+    Pool& m_pool;
+    size_t m_grain;
+};
+
+class Parallel
+{
+public:
+    template <typename Policy, typename RandomIt, typename F>
+    static void ForEach(Policy const& policy, RandomIt first, RandomIt last, F func)
+    {
+        policy.ForEachBlock(last - first, [&](size_t, size_t lo, size_t hi) {std::for_each(first + lo, first + hi, func);});
+    }
+
+    /**
+     * A parallel reduce: every block counts into its own slot, the slots are summed at the end
+     */
+    template <typename Policy, typename RandomIt, typename Pred>
+    static size_t CountIf(Policy const& policy, RandomIt first, RandomIt last, Pred pred)
+    {
+        std::vector<size_t> counts(policy.Blocks(last - first));
+        policy.ForEachBlock(last - first, [&](size_t block, size_t lo, size_t hi) {
+            counts[block] = std::count_if(first + lo, first + hi, pred);
+        });
+        size_t total{0};
+        for (auto cur: counts)
+        {
+            total += cur;
+        }
+        return total;
+    }
+
+    /**
+     * Blocks check every CancelCheck elements whether another block has already found a match, and give up if so
+     */
+    template <typename Policy, typename RandomIt, typename Pred>
+    static bool AnyOf(Policy const& policy, RandomIt first, RandomIt last, Pred pred)
+    {
+        std::atomic<bool> found{false};
+        policy.ForEachBlock(last - first, [&](size_t, size_t lo, size_t hi) {
+            while (lo < hi && !found.load(std::memory_order_relaxed))
+            {
+                auto stop = std::min(hi, lo + CancelCheck);
+                if (std::any_of(first + lo, first + stop, pred))
+                {
+                    found.store(true, std::memory_order_relaxed);
+                }
+                lo = stop;
+            }
+        });
+        return found.load();
+    }
+
+    template <typename Policy, typename RandomIt, typename Pred>
+    static bool AllOf(Policy const& policy, RandomIt first, RandomIt last, Pred pred)
+    {
+        return !AnyOf(policy, first, last, [&](auto const& value) {return !pred(value);});
+    }
+
+    template <typename Policy, typename RandomIt, typename Pred>
+    static bool NoneOf(Policy const& policy, RandomIt first, RandomIt last, Pred pred)
+    {
+        return !AnyOf(policy, first, last, pred);
+    }
+
+    /**
+     * dest must be random access and have room for the whole range (not a back_inserter)
+     */
+    template <typename Policy, typename RandomIt, typename OutIt, typename Op>
+    static OutIt Transform(Policy const& policy, RandomIt first, RandomIt last, OutIt dest, Op op)
+    {
+        policy.ForEachBlock(last - first, [&](size_t, size_t lo, size_t hi) {
+            std::transform(first + lo, first + hi, dest + lo, op);
+        });
+        return dest + (last - first);
+    }
+
+    /**
+     * Scan based: count each block's matches, turn the counts into output offsets with an exclusive scan, then every
+     * block copies its matches to its own offset. pred is called twice per element. dest must be random access with
+     * room for every match; the order of the range is kept.
+     */
+    template <typename Policy, typename RandomIt, typename OutIt, typename Pred>
+    static OutIt CopyIf(Policy const& policy, RandomIt first, RandomIt last, OutIt dest, Pred pred)
+    {
+        auto offsets = BlockOffsets(policy, last - first, [&](size_t, size_t lo, size_t hi) {
+            return static_cast<size_t>(std::count_if(first + lo, first + hi, pred));
+        });
+        policy.ForEachBlock(last - first, [&](size_t block, size_t lo, size_t hi) {
+            std::copy_if(first + lo, first + hi, dest + offsets[block], pred);
+        });
+        return dest + offsets.back();
+    }
+
+    /**
+     * Every block compacts itself with std::remove_if, then the kept prefixes are moved down to their scanned offsets
+     * (through a buffer, as a block's destination can overlap the prefixes of the blocks before it). Stable, and pred
+     * is called once per element.
+     */
+    template <typename Policy, typename RandomIt, typename Pred>
+    static RandomIt RemoveIf(Policy const& policy, RandomIt first, RandomIt last, Pred pred)
+    {
+        std::vector<size_t> ends(policy.Blocks(last - first)); //end of each block's kept prefix
+        auto offsets = BlockOffsets(policy, last - first, [&](size_t block, size_t lo, size_t hi) {
+            ends[block] = std::remove_if(first + lo, first + hi, pred) - first;
+            return ends[block] - lo;
+        });
+        if (ends.size() == 1)
+        {
+            return first + ends[0];
+        }
+
+        std::vector<Value<RandomIt>> kept(offsets.back());
+        policy.ForEachBlock(last - first, [&](size_t block, size_t lo, size_t) {
+            std::move(first + lo, first + ends[block], kept.begin() + offsets[block]);
+        });
+        policy.ForEachBlock(kept.size(), [&](size_t, size_t lo, size_t hi) {
+            std::move(kept.begin() + lo, kept.begin() + hi, first + lo);
+        });
+        return first + kept.size();
+    }
+
+    /**
+     * Every block partitions itself, then the blocks' true parts are gathered at the front and their false parts
+     * behind them, through a buffer. Not stable (neither is std::partition), pred is called once per element.
+     */
+    template <typename Policy, typename RandomIt, typename Pred>
+    static RandomIt Partition(Policy const& policy, RandomIt first, RandomIt last, Pred pred)
+    {
+        size_t count = last - first;
+        std::vector<size_t> mids(policy.Blocks(count)); //end of each block's true part
+        auto trueOffsets = BlockOffsets(policy, count, [&](size_t block, size_t lo, size_t hi) {
+            mids[block] = std::partition(first + lo, first + hi, pred) - first;
+            return mids[block] - lo;
+        });
+        auto trueCount = trueOffsets.back();
+        if (mids.size() == 1)
+        {
+            return first + trueCount;
+        }
+
+        std::vector<Value<RandomIt>> buffer(count);
+        policy.ForEachBlock(count, [&](size_t block, size_t lo, size_t hi) {
+            auto falseOffset = trueCount + (lo - trueOffsets[block]); //false elements in the blocks before this one
+            std::move(first + lo, first + mids[block], buffer.begin() + trueOffsets[block]);
+            std::move(first + mids[block], first + hi, buffer.begin() + falseOffset);
+        });
+        MoveBack(policy, buffer, first);
+        return first + trueCount;
+    }
+
+    /**
+     * Merge path: output position k of a stable merge takes CoRank(k) elements from the first range and the rest from
+     * the second, found with a binary search. Every block of the output merges its own slice of each range.
+     */
+    template <typename Policy, typename RandomIt1, typename RandomIt2, typename OutIt, typename Compare = std::less<>>
+    static OutIt Merge(Policy const& policy, RandomIt1 first1, RandomIt1 last1, RandomIt2 first2, RandomIt2 last2,
+                       OutIt dest, Compare comp = {})
+    {
+        size_t size1 = last1 - first1;
+        size_t size2 = last2 - first2;
+        policy.ForEachBlock(size1 + size2, [&](size_t, size_t lo, size_t hi) {
+            auto lo1 = CoRank(lo, first1, size1, first2, size2, comp);
+            auto hi1 = CoRank(hi, first1, size1, first2, size2, comp);
+            std::merge(first1 + lo1, first1 + hi1, first2 + (lo - lo1), first2 + (hi - hi1), dest + lo, comp);
+        });
+        return dest + (size1 + size2);
+    }
+
+    /**
+     * Every block is sorted with std::sort, then neighbouring runs are merged pairwise, each round with all the
+     * workers on Merge's co-ranked slices, ping-ponging between the range and a buffer. Not stable.
+     */
+    template <typename Policy, typename RandomIt, typename Compare = std::less<>>
+    static void Sort(Policy const& policy, RandomIt first, RandomIt last, Compare comp = {})
+    {
+        MergeSort(policy, first, last, comp, [&](RandomIt lo, RandomIt hi) {std::sort(lo, hi, comp);});
+    }
+
+    /**
+     * As Sort, with the blocks sorted by std::stable_sort. The merges take the earlier run's element on ties, so
+     * equal elements keep their order.
+     */
+    template <typename Policy, typename RandomIt, typename Compare = std::less<>>
+    static void StableSort(Policy const& policy, RandomIt first, RandomIt last, Compare comp = {})
+    {
+        MergeSort(policy, first, last, comp, [&](RandomIt lo, RandomIt hi) {std::stable_sort(lo, hi, comp);});
+    }
+
+    /**
+     * Quickselect with parallel partitions: a pivot is drawn from a sample at nth's quantile, the range is split into
+     * less than, equal to and greater than it, and only the part holding nth is carried on with. Once that part is
+     * too small to be worth going parallel std::nth_element finishes it.
+     */
+    template <typename Policy, typename RandomIt, typename Compare = std::less<>>
+    static void NthElement(Policy const& policy, RandomIt first, RandomIt nth, RandomIt last, Compare comp = {})
+    {
+        while (nth != last && policy.Blocks(last - first) > 1)
+        {
+            size_t count = last - first;
+            std::vector<Value<RandomIt>> sample;
+            for (size_t idx=0; idx < SampleSize; ++idx)
+            {
+                sample.push_back(first[idx * count / SampleSize]);
+            }
+            auto rank = sample.begin() + (nth - first) * SampleSize / count;
+            std::nth_element(sample.begin(), rank, sample.end(), comp);
+            auto pivot = *rank;
+
+            auto less = Partition(policy, first, last, [&](auto const& value) {return comp(value, pivot);});
+            if (nth < less)
+            {
+                last = less;
+                continue;
+            }
+            auto equal = Partition(policy, less, last, [&](auto const& value) {return !comp(pivot, value);});
+            if (nth < equal)
+            {
+                return; //nth is one of the elements equal to the pivot, which are all in place
+            }
+            first = equal;
+        }
+        std::nth_element(first, nth, last, comp);
+    }
+
+private:
+    static constexpr size_t CancelCheck{4096};
+    static constexpr size_t SampleSize{255};
+
+    template <typename It>
+    using Value = typename std::iterator_traits<It>::value_type;
+
+    /**
+     * Run count(block, lo, hi) over the blocks of [0, size), and return the exclusive scan of the counts: entry b is
+     * where block b's output starts, and the extra last entry is the total
+     */
+    template <typename Policy, typename Count>
+    static std::vector<size_t> BlockOffsets(Policy const& policy, size_t size, Count count)
+    {
+        std::vector<size_t> offsets(policy.Blocks(size) + 1);
+        policy.ForEachBlock(size, [&](size_t block, size_t lo, size_t hi) {offsets[block + 1] = count(block, lo, hi);});
+        for (auto block=1U; block < offsets.size(); ++block)
+        {
+            offsets[block] += offsets[block - 1];
+        }
+        return offsets;
+    }
+
+    template <typename Policy, typename RandomIt, typename Compare, typename BlockSort>
+    static void MergeSort(Policy const& policy, RandomIt first, RandomIt last, Compare& comp, BlockSort blockSort)
+    {
+        size_t count = last - first;
+        auto blocks = policy.Blocks(count);
+        if (blocks == 1)
+        {
+            blockSort(first, last);
+            return;
+        }
+
+        std::vector<size_t> runs; //run r is [runs[r], runs[r + 1])
+        for (auto block=0U; block <= blocks; ++block)
+        {
+            runs.push_back(block * count / blocks);
+        }
+        policy.ForEachIndex(blocks, [&](size_t block) {blockSort(first + runs[block], first + runs[block + 1]);});
+
+        std::vector<Value<RandomIt>> buffer(count);
+        bool inBuffer{false};
+        while (runs.size() > 2)
+        {
+            if (inBuffer)
+            {
+                MergeRuns(policy, buffer.begin(), first, runs, comp);
+            }
+            else
+            {
+                MergeRuns(policy, first, buffer.begin(), runs, comp);
+            }
+            inBuffer = !inBuffer;
+        }
+        if (inBuffer)
+        {
+            MoveBack(policy, buffer, first);
+        }
+    }
+
+    template <typename Policy, typename T, typename RandomIt>
+    static void MoveBack(Policy const& policy, std::vector<T>& buffer, RandomIt dest)
+    {
+        policy.ForEachBlock(buffer.size(), [&](size_t, size_t lo, size_t hi) {
+            std::move(buffer.begin() + lo, buffer.begin() + hi, dest + lo);
+        });
+    }
+
+    /**
+     * How many of the first k elements of the stable merge of a[0, size1) and b[0, size2) come from a: the smallest i
+     * for which b[k - i - 1] sorts strictly before a[i]
+     */
+    template <typename RandomIt1, typename RandomIt2, typename Compare>
+    static size_t CoRank(size_t k, RandomIt1 a, size_t size1, RandomIt2 b, size_t size2, Compare& comp)
+    {
+        size_t lo = k > size2 ? k - size2 : 0;
+        size_t hi = std::min(k, size1);
+        while (lo < hi)
+        {
+            auto mid = lo + (hi - lo) / 2;
+            if (comp(b[k - mid - 1], a[mid]))
+            {
+                hi = mid;
+            }
+            else
+            {
+                lo = mid + 1;
+            }
+        }
+        return lo;
+    }
+
+    /**
+     * One round of MergeSort: merge runs 0 and 1, 2 and 3... of src into dest (an odd last run is just moved), and halve
+     * runs to match. The output is cut into about Blocks(size) slices across all the pairs.
+     */
+    template <typename Policy, typename SrcIt, typename DestIt, typename Compare>
+    static void MergeRuns(Policy const& policy, SrcIt src, DestIt dest, std::vector<size_t>& runs, Compare& comp)
+    {
+        struct Slice
+        {
+            size_t m_begin; //of the pair
+            size_t m_mid;
+            size_t m_end;
+            size_t m_lo; //of this slice's output, relative to m_begin
+            size_t m_hi;
+            size_t m_lo1{0}; //how much of that comes from the first run
+            size_t m_hi1{0};
+        };
+
+        auto size = runs.back();
+        auto sliceSize = (size + policy.Blocks(size) - 1) / policy.Blocks(size);
+        std::vector<Slice> slices;
+        std::vector<size_t> merged;
+        for (auto run=0U; run + 1 < runs.size(); run += 2)
+        {
+            auto begin = runs[run];
+            auto mid = runs[run + 1];
+            auto end = run + 2 < runs.size() ? runs[run + 2] : mid;
+            for (auto lo=size_t{0}; lo < end - begin; lo += sliceSize)
+            {
+                slices.push_back(Slice{begin, mid, end, lo, std::min(end - begin, lo + sliceSize)});
+            }
+            merged.push_back(begin);
+        }
+        merged.push_back(size);
+
+        //all the co-ranks first, the binary searches read elements a neighbouring slice would already have moved out
+        policy.ForEachIndex(slices.size(), [&](size_t idx) {
+            auto& cur = slices[idx];
+            auto size1 = cur.m_mid - cur.m_begin;
+            auto size2 = cur.m_end - cur.m_mid;
+            cur.m_lo1 = CoRank(cur.m_lo, src + cur.m_begin, size1, src + cur.m_mid, size2, comp);
+            cur.m_hi1 = CoRank(cur.m_hi, src + cur.m_begin, size1, src + cur.m_mid, size2, comp);
+        });
+        policy.ForEachIndex(slices.size(), [&](size_t idx) {
+            auto& cur = slices[idx];
+            auto a = std::make_move_iterator(src + cur.m_begin);
+            auto b = std::make_move_iterator(src + cur.m_mid);
+            std::merge(a + cur.m_lo1, a + cur.m_hi1, b + (cur.m_lo - cur.m_lo1), b + (cur.m_hi - cur.m_hi1),
+                       dest + cur.m_begin + cur.m_lo, comp);
+        });
+        runs = std::move(merged);
+    }
+};
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <random>
+#include <thread>
+#include <iostream>
+#include <iomanip>
+
+#include "parallel_algorithm.h"
+#include "../Threading/thread_pool.h"
+#include "../Threading/bench.h"
+#include "../Threading/pool_workloads.h"
+
+/**
+ * Times each Parallel algorithm against its std counterpart on the same data, at 1, 2, 4... threads, and prints the
+ * speedups over std at the end
+ */
+
+/**
+ * Takes the number of elements (default 10^8), the most threads to try (default one per hardware thread), and the
+ * options in bench.h
+ */
+int main(int argc, char* argv[])
+{
+    BenchSuite suite{"parallel", argc, argv};
+    size_t count = suite.Arg(0, 100000000);
+    size_t maxThreads = suite.Arg(1, std::max(1U, std::thread::hardware_concurrency()));
+
+    std::mt19937 rng{42};
+    std::vector<int> values(count);
+    std::generate(std::begin(values), std::end(values), [&]{return static_cast<int>(rng() % 1000000);});
+    std::vector<int> lower(values.begin(), values.begin() + count / 2); //the two halves, sorted, for merge
+    std::vector<int> upper(values.begin() + count / 2, values.end());
+    std::sort(std::begin(lower), std::end(lower));
+    std::sort(std::begin(upper), std::end(upper));
+
+    auto isOdd = [](auto value) {return (value % 2) == 1;};
+    auto triple = [](auto value) {return value * 3 + 1;};
+    std::vector<int> work;
+    std::vector<int> out(count);
+    auto reset = [&]{work = values;};
+
+    suite.Run("std/count_if", [&]{DoNotOptimize(std::count_if(std::cbegin(values), std::cend(values), isOdd));}, count);
+    suite.Run("std/all_of", [&]{DoNotOptimize(std::all_of(std::cbegin(values), std::cend(values), [](auto value){return value >= 0;}));}, count);
+    suite.Run("std/transform", [&]{std::transform(std::cbegin(values), std::cend(values), std::begin(out), triple);}, count);
+    suite.Run("std/copy_if", [&]{DoNotOptimize(std::copy_if(std::cbegin(values), std::cend(values), std::begin(out), isOdd));}, count);
+    suite.RunWithSetup("std/remove_if", reset, [&]{DoNotOptimize(std::remove_if(std::begin(work), std::end(work), isOdd));}, count);
+    suite.RunWithSetup("std/partition", reset, [&]{DoNotOptimize(std::partition(std::begin(work), std::end(work), isOdd));}, count);
+    suite.RunWithSetup("std/sort", reset, [&]{std::sort(std::begin(work), std::end(work));}, count);
+    suite.RunWithSetup("std/nth_element", reset, [&]{
+        std::nth_element(std::begin(work), std::begin(work) + count / 2, std::end(work));
+    }, count);
+    suite.Run("std/merge", [&]{
+        std::merge(std::cbegin(lower), std::cend(lower), std::cbegin(upper), std::cend(upper), std::begin(out));
+    }, count);
+
+    for (auto threads: ThreadCounts(maxThreads))
+    {
+        ThreadPool pool{threads};
+        pool.Start();
+        ParallelPolicy policy{pool};
+        auto suffix = "/threads" + std::to_string(threads);
+
+        suite.Run("parallel/count_if" + suffix, [&]{
+            DoNotOptimize(Parallel::CountIf(policy, std::cbegin(values), std::cend(values), isOdd));
+        }, count);
+        suite.Run("parallel/all_of" + suffix, [&]{
+            DoNotOptimize(Parallel::AllOf(policy, std::cbegin(values), std::cend(values), [](auto value){return value >= 0;}));
+        }, count);
+        suite.Run("parallel/transform" + suffix, [&]{
+            Parallel::Transform(policy, std::cbegin(values), std::cend(values), std::begin(out), triple);
+        }, count);
+        suite.Run("parallel/copy_if" + suffix, [&]{
+            DoNotOptimize(Parallel::CopyIf(policy, std::cbegin(values), std::cend(values), std::begin(out), isOdd));
+        }, count);
+        suite.RunWithSetup("parallel/remove_if" + suffix, reset, [&]{
+            DoNotOptimize(Parallel::RemoveIf(policy, std::begin(work), std::end(work), isOdd));
+        }, count);
+        suite.RunWithSetup("parallel/partition" + suffix, reset, [&]{
+            DoNotOptimize(Parallel::Partition(policy, std::begin(work), std::end(work), isOdd));
+        }, count);
+        suite.RunWithSetup("parallel/sort" + suffix, reset, [&]{Parallel::Sort(policy, std::begin(work), std::end(work));}, count);
+        suite.Check(std::is_sorted(std::cbegin(work), std::cend(work)), "Parallel::Sort" + suffix);
+        suite.RunWithSetup("parallel/nth_element" + suffix, reset, [&]{
+            Parallel::NthElement(policy, std::begin(work), std::begin(work) + count / 2, std::end(work));
+        }, count);
+        suite.Run("parallel/merge" + suffix, [&]{
+            Parallel::Merge(policy, std::cbegin(lower), std::cend(lower), std::cbegin(upper), std::cend(upper), std::begin(out));
+        }, count);
+        suite.Check(std::is_sorted(std::cbegin(out), std::cend(out)), "Parallel::Merge" + suffix);
+
+        pool.Stop();
+    }
+
+    std::cout << std::endl << std::left << std::setw(40) << "speedup over std" << std::right << std::setw(10) << "x" << std::endl;
+    for (auto const& cur: suite.Results())
+    {
+        auto op = cur.m_name.substr(0, cur.m_name.rfind('/'));
+        if (op.rfind("parallel/", 0) != 0)
+        {
+            continue;
+        }
+        for (auto const& base: suite.Results())
+        {
+            if (base.m_name == "std/" + op.substr(9))
+            {
+                std::cout << std::left << std::setw(40) << cur.m_name << std::right << std::fixed << std::setprecision(2)
+                          << std::setw(10) << base.m_medianNs / cur.m_medianNs << std::endl;
+            }
+        }
+    }
+    return suite.Finish();
+}
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <random>
+#include <thread>
+#include <utility>
+#include <numeric>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+
+#include "radix_sort.h"
+#include "parallel_algorithm.h"
+#include "../Threading/thread_pool.h"
+#include "../Threading/bench.h"
+
+/**
+ * Times RadixSort and the Parallel merge sorts against std::sort on random 32 and 64 bit keys and doubles, and on
+ * key-value pairs, at 10^6, 10^7... elements
+ */
+
+template <typename Key, typename Policy, typename Generate>
+void BenchKeys(BenchSuite& suite, Policy const& policy, std::string const& type, size_t count, Generate generate)
+{
+    std::vector<Key> values(count);
+    std::generate(std::begin(values), std::end(values), generate);
+    std::vector<Key> expected{values};
+    std::sort(std::begin(expected), std::end(expected));
+    std::vector<Key> work;
+    auto reset = [&]{work = values;};
+    auto size = "/1e" + std::to_string(static_cast<int>(std::log10(count) + 0.5));
+
+    suite.RunWithSetup(type + "/std_sort" + size, reset, [&]{std::sort(std::begin(work), std::end(work));}, count);
+    suite.RunWithSetup(type + "/parallel_sort" + size, reset, [&]{Parallel::Sort(policy, std::begin(work), std::end(work));}, count);
+    suite.Check(work == expected, "Parallel::Sort of " + type + size);
+    suite.RunWithSetup(type + "/radix" + size, reset, [&]{RadixSort::Sort(policy, std::begin(work), std::end(work));}, count);
+    suite.Check(std::memcmp(work.data(), expected.data(), count * sizeof(Key)) == 0, "RadixSort of " + type + size);
+}
+
+/**
+ * Takes the largest size as a power of 10 (default 8, 9 needs about 32GB for the 64 bit keys), the threads (default
+ * one per hardware thread), and the options in bench.h
+ */
+int main(int argc, char* argv[])
+{
+    BenchSuite suite{"radix", argc, argv};
+    size_t maxPower = suite.Arg(0, 8);
+    size_t threads = suite.Arg(1, std::max(1U, std::thread::hardware_concurrency()));
+
+    ThreadPool pool{threads};
+    pool.Start();
+    ParallelPolicy policy{pool};
+
+    std::mt19937_64 rng{42};
+    for (size_t count=1000000, power=6; power <= maxPower; count *= 10, ++power)
+    {
+        BenchKeys<uint32_t>(suite, policy, "u32", count, [&]{return static_cast<uint32_t>(rng());});
+        BenchKeys<int32_t>(suite, policy, "i32", count, [&]{return static_cast<int32_t>(rng());});
+        BenchKeys<uint64_t>(suite, policy, "u64", count, [&]{return rng();});
+        BenchKeys<double>(suite, policy, "f64", count, [&]{return std::ldexp(static_cast<double>(static_cast<int64_t>(rng())), -40);});
+
+        //key-value: std sorts pairs on the key, RadixSort moves the values with the keys, StableSort is the
+        //comparator fallback
+        auto size = "/1e" + std::to_string(power);
+        std::vector<uint32_t> keys(count);
+        std::generate(std::begin(keys), std::end(keys), [&]{return static_cast<uint32_t>(rng());});
+        std::vector<std::pair<uint32_t, uint32_t>> pairs(count);
+        std::vector<uint32_t> sortedKeys;
+        std::vector<uint32_t> sortedValues;
+        auto byKey = [](auto const& lhs, auto const& rhs) {return lhs.first < rhs.first;};
+        auto resetPairs = [&]{
+            for (auto idx=0U; idx < count; ++idx)
+            {
+                pairs[idx] = {keys[idx], idx};
+            }
+        };
+        auto resetKeys = [&]{
+            sortedKeys = keys;
+            sortedValues.resize(count);
+            std::iota(std::begin(sortedValues), std::end(sortedValues), 0);
+        };
+        suite.RunWithSetup("pairs/std_sort" + size, resetPairs, [&]{std::sort(std::begin(pairs), std::end(pairs), byKey);}, count);
+        suite.RunWithSetup("pairs/parallel_stable_sort" + size, resetPairs, [&]{
+            Parallel::StableSort(policy, std::begin(pairs), std::end(pairs), byKey);
+        }, count);
+        suite.RunWithSetup("pairs/radix" + size, resetKeys, [&]{
+            RadixSort::SortPairs(policy, std::begin(sortedKeys), std::end(sortedKeys), std::begin(sortedValues));
+        }, count);
+        bool same{true};
+        for (auto idx=0U; idx < count; ++idx)
+        {
+            same = same && pairs[idx].first == sortedKeys[idx] && pairs[idx].second == sortedValues[idx];
+        }
+        suite.Check(same, "RadixSort::SortPairs against Parallel::StableSort" + size);
+    }
+    pool.Stop();
+    return suite.Finish();
+}
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <array>
+#include <cstring>
+#include <cstdint>
+
+#include "parallel_algorithm.h"
+
+/**
+ * The unsigned integer that sorts the same way as an arithmetic T: unsigned keys as they are, signed ones with the
+ * sign bit flipped, and IEEE floats with the sign bit flipped when positive and every bit flipped when negative.
+ * For floats the order is total: -NaN < -inf < ... < -0 < +0 < ... < +inf < +NaN.
+ */
+template <typename T>
+class RadixKey
+{
+public:
+    static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool> && sizeof(T) <= 8, "RadixKey needs a number of at most 64 bits");
+
+    using Bits = std::conditional_t<sizeof(T) == 1, uint8_t,
+                 std::conditional_t<sizeof(T) == 2, uint16_t,
+                 std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>>;
+
+    static constexpr Bits SignBit = static_cast<Bits>(Bits{1} << (sizeof(T) * 8 - 1));
+
+    static Bits ToBits(T value)
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            Bits bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return (bits & SignBit) ? static_cast<Bits>(~bits) : static_cast<Bits>(bits | SignBit);
+        }
+        else if constexpr (std::is_signed_v<T>)
+        {
+            return static_cast<Bits>(static_cast<Bits>(value) ^ SignBit);
+        }
+        else
+        {
+            return value;
+        }
+    }
+};
+
+/**
+ * LSD radix sort on one of our ThreadPools, for ranges of numbers (or numbers with values riding along), one byte
+ * of the key per pass:
+ *  - one parallel read of the range counts every digit of every block at once. A digit that is the same for every key
+ *    (e.g. the top bytes of small numbers) has one full bucket, and its pass is skipped.
+ *  - every other pass turns the per block counts into where each block's share of each bucket starts (bucket by
+ *    bucket, block by block), then every block scatters its keys to those places in order, so the sort is stable.
+ *    The passes ping-pong between the range and a buffer. Only the first pass can use the up front counts, the
+ *    later ones count their blocks again.
+ *
+ * Ranges shorter than SmallSort are just sorted with std::sort on the keys. Anything that needs a comparator goes
+ * to Parallel::Sort or Parallel::StableSort instead.
+ */
+class RadixSort
+{
+public:
+    static constexpr size_t SmallSort{1024};
+    static constexpr size_t Buckets{256};
+
+    template <typename Policy, typename RandomIt>
+    static void Sort(Policy const& policy, RandomIt first, RandomIt last)
+    {
+        using Key = typename std::iterator_traits<RandomIt>::value_type;
+        size_t count = last - first;
+        if (count < SmallSort)
+        {
+            std::sort(first, last, [](Key lhs, Key rhs) {return RadixKey<Key>::ToBits(lhs) < RadixKey<Key>::ToBits(rhs);});
+            return;
+        }
+        std::vector<Key> buffer(count);
+        Passes(policy, first, NoValues{}, buffer.begin(), NoValues{}, count);
+    }
+
+    /**
+     * Sort the keys, and move values[i] to wherever keys[i] ends up. Keys that compare equal keep their order.
+     */
+    template <typename Policy, typename KeyIt, typename ValueIt>
+    static void SortPairs(Policy const& policy, KeyIt keysFirst, KeyIt keysLast, ValueIt valuesFirst)
+    {
+        using Key = typename std::iterator_traits<KeyIt>::value_type;
+        using Value = typename std::iterator_traits<ValueIt>::value_type;
+        size_t count = keysLast - keysFirst;
+        std::vector<Key> keyBuffer(count);
+        std::vector<Value> valueBuffer(count);
+        Passes(policy, keysFirst, valuesFirst, keyBuffer.begin(), valueBuffer.begin(), count);
+    }
+
+private:
+    /**
+     * Stands in for the values when there are none, every move to or from it does nothing
+     */
+    struct NoValues
+    {
+        struct Slot {};
+        Slot operator[](size_t) const {return {};}
+    };
+
+    using Counts = std::array<size_t, Buckets>;
+
+    template <typename Key>
+    static size_t Digit(Key key, unsigned digit)
+    {
+        return (RadixKey<Key>::ToBits(key) >> (digit * 8)) & (Buckets - 1);
+    }
+
+    template <typename Policy, typename KeyIt, typename ValueIt, typename KeyBuf, typename ValueBuf>
+    static void Passes(Policy const& policy, KeyIt keys, ValueIt values, KeyBuf keyBuffer, ValueBuf valueBuffer, size_t count)
+    {
+        using Key = typename std::iterator_traits<KeyIt>::value_type;
+        constexpr unsigned Digits = sizeof(Key);
+        auto blocks = policy.Blocks(count);
+
+        //counts[block * Digits + digit]
+        std::vector<Counts> counts(blocks * Digits);
+        policy.ForEachBlock(count, [&](size_t block, size_t lo, size_t hi) {
+            auto blockCounts = &counts[block * Digits];
+            std::fill(blockCounts, blockCounts + Digits, Counts{});
+            for (auto idx=lo; idx < hi; ++idx)
+            {
+                auto bits = RadixKey<Key>::ToBits(keys[idx]);
+                for (auto digit=0U; digit < Digits; ++digit)
+                {
+                    ++blockCounts[digit][(bits >> (digit * 8)) & (Buckets - 1)];
+                }
+            }
+        });
+
+        std::vector<Counts> starts(blocks); //where each block's share of each bucket goes, for the current pass
+        std::array<bool, Digits> needed; //the bucket totals don't depend on the arrangement, so this can be decided now
+        for (auto digit=0U; digit < Digits; ++digit)
+        {
+            needed[digit] = Starts(counts, digit, Digits, count, starts);
+        }
+
+        bool inBuffer{false};
+        bool counted{true}; //counts still describe the blocks as they are arranged now
+        for (auto digit=0U; digit < Digits; ++digit)
+        {
+            if (!needed[digit])
+            {
+                continue; //every key has the same digit here
+            }
+            if (!counted)
+            {
+                auto countDigit = [&](auto src) {
+                    policy.ForEachBlock(count, [&](size_t block, size_t lo, size_t hi) {
+                        auto& cur = counts[block * Digits + digit];
+                        cur.fill(0);
+                        for (auto idx=lo; idx < hi; ++idx)
+                        {
+                            ++cur[Digit(src[idx], digit)];
+                        }
+                    });
+                };
+                inBuffer ? countDigit(keyBuffer) : countDigit(keys);
+            }
+            Starts(counts, digit, Digits, count, starts);
+
+            if (inBuffer)
+            {
+                Scatter(policy, keyBuffer, valueBuffer, keys, values, count, digit, starts);
+            }
+            else
+            {
+                Scatter(policy, keys, values, keyBuffer, valueBuffer, count, digit, starts);
+            }
+            inBuffer = !inBuffer;
+            counted = false;
+        }
+
+        if (inBuffer)
+        {
+            policy.ForEachBlock(count, [&](size_t, size_t lo, size_t hi) {
+                for (auto idx=lo; idx < hi; ++idx)
+                {
+                    keys[idx] = std::move(keyBuffer[idx]);
+                    values[idx] = std::move(valueBuffer[idx]);
+                }
+            });
+        }
+    }
+
+    /**
+     * Exclusive scan of one digit's counts, bucket by bucket and block by block within a bucket. False if a single
+     * bucket holds every key, i.e. the pass would change nothing.
+     */
+    static bool Starts(std::vector<Counts> const& counts, unsigned digit, unsigned digits, size_t count, std::vector<Counts>& starts)
+    {
+        size_t total{0};
+        for (auto bucket=0U; bucket < Buckets; ++bucket)
+        {
+            auto bucketStart = total;
+            for (auto block=0U; block < starts.size(); ++block)
+            {
+                starts[block][bucket] = total;
+                total += counts[block * digits + digit][bucket];
+            }
+            if (total - bucketStart == count)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename Policy, typename SrcKeys, typename SrcValues, typename DestKeys, typename DestValues>
+    static void Scatter(Policy const& policy, SrcKeys srcKeys, SrcValues srcValues, DestKeys destKeys, DestValues destValues,
+                        size_t count, unsigned digit, std::vector<Counts>& starts)
+    {
+        policy.ForEachBlock(count, [&](size_t block, size_t lo, size_t hi) {
+            auto& next = starts[block];
+            for (auto idx=lo; idx < hi; ++idx)
+            {
+                auto slot = next[Digit(srcKeys[idx], digit)]++;
+                destKeys[slot] = std::move(srcKeys[idx]);
+                destValues[slot] = std::move(srcValues[idx]);
+            }
+        });
+    }
+};
@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <random>
+#include <thread>
+#include <utility>
+#include <cmath>
+#include <cstdint>
+
+#include "sorted_sets.h"
+#include "parallel_algorithm.h"
+#include "../Threading/thread_pool.h"
+#include "../Threading/bench.h"
+
+/**
+ * Times SortedSets against the std set algorithms on sorted ID lists: short lists against one of 10^8 (galloping),
+ * two lists of similar size (the AVX2 intersection), the partitioned versions, and IntersectAll against chained
+ * std::set_intersection
+ */
+
+using Ids = std::vector<uint32_t>;
+
+/**
+ * count sorted IDs, half of them taken from from (so intersections aren't empty) and the rest random
+ */
+Ids MakeIds(std::mt19937_64& rng, size_t count, Ids const& from)
+{
+    Ids ids(count);
+    for (auto idx=0U; idx < count; ++idx)
+    {
+        ids[idx] = (idx % 2 == 0 && !from.empty()) ? from[rng() % from.size()] : static_cast<uint32_t>(rng());
+    }
+    std::sort(std::begin(ids), std::end(ids));
+    ids.erase(std::unique(std::begin(ids), std::end(ids)), std::end(ids));
+    return ids;
+}
+
+std::string Size(size_t count)
+{
+    return "1e" + std::to_string(static_cast<int>(std::log10(count) + 0.5));
+}
+
+/**
+ * Takes the size of the long list as a power of 10 (default 8), the threads (default one per hardware thread), and
+ * the options in bench.h
+ */
+int main(int argc, char* argv[])
+{
+    BenchSuite suite{"sets", argc, argv};
+    size_t maxPower = suite.Arg(0, 8);
+    size_t threads = suite.Arg(1, std::max(1U, std::thread::hardware_concurrency()));
+
+    ThreadPool pool{threads};
+    pool.Start();
+    ParallelPolicy policy{pool};
+
+    std::mt19937_64 rng{42};
+    auto large = MakeIds(rng, static_cast<size_t>(std::pow(10, maxPower)), {});
+    Ids out(2 * large.size());
+    Ids expected;
+    auto check = [&](uint32_t* last, std::string const& what) {
+        suite.Check(static_cast<size_t>(last - out.data()) == expected.size() && std::equal(out.data(), last, std::cbegin(expected)), what);
+    };
+
+    //skewed: the short list decides the cost of SortedSets, the long one that of std
+    for (size_t count: {1000, 100000})
+    {
+        auto small = MakeIds(rng, count, large);
+        auto name = Size(count) + "_vs_" + Size(large.size());
+        uint32_t* last{nullptr};
+
+        expected.clear();
+        std::set_intersection(small.cbegin(), small.cend(), large.cbegin(), large.cend(), std::back_inserter(expected));
+        suite.Run("intersection/std/" + name, [&]{
+            DoNotOptimize(last = std::set_intersection(small.cbegin(), small.cend(), large.cbegin(), large.cend(), out.data()));
+        }, large.size());
+        check(last, "std intersection " + name);
+        suite.Run("intersection/sorted_sets/" + name, [&]{
+            DoNotOptimize(last = SortedSets::Intersection(small.cbegin(), small.cend(), large.cbegin(), large.cend(), out.data()));
+        }, large.size());
+        check(last, "SortedSets::Intersection " + name);
+
+        expected.clear();
+        std::set_difference(small.cbegin(), small.cend(), large.cbegin(), large.cend(), std::back_inserter(expected));
+        suite.Run("difference/std/" + name, [&]{
+            DoNotOptimize(last = std::set_difference(small.cbegin(), small.cend(), large.cbegin(), large.cend(), out.data()));
+        }, large.size());
+        suite.Run("difference/sorted_sets/" + name, [&]{
+            DoNotOptimize(last = SortedSets::Difference(small.cbegin(), small.cend(), large.cbegin(), large.cend(), out.data()));
+        }, large.size());
+        check(last, "SortedSets::Difference " + name);
+
+        //both write the whole long list, so this is copy against merge
+        expected.clear();
+        std::set_union(small.cbegin(), small.cend(), large.cbegin(), large.cend(), std::back_inserter(expected));
+        suite.Run("union/std/" + name, [&]{
+            DoNotOptimize(last = std::set_union(small.cbegin(), small.cend(), large.cbegin(), large.cend(), out.data()));
+        }, large.size());
+        suite.Run("union/sorted_sets/" + name, [&]{
+            DoNotOptimize(last = SortedSets::Union(small.cbegin(), small.cend(), large.cbegin(), large.cend(), out.data()));
+        }, large.size());
+        check(last, "SortedSets::Union " + name);
+    }
+
+    //similar sizes: a tenth of the long list against another of the same size
+    {
+        auto lhs = MakeIds(rng, large.size() / 10, large);
+        auto rhs = MakeIds(rng, large.size() / 10, lhs);
+        auto name = Size(lhs.size()) + "_vs_" + Size(rhs.size());
+        auto items = lhs.size() + rhs.size();
+        uint32_t* last{nullptr};
+
+        expected.clear();
+        std::set_intersection(lhs.cbegin(), lhs.cend(), rhs.cbegin(), rhs.cend(), std::back_inserter(expected));
+        suite.Run("intersection/std/" + name, [&]{
+            DoNotOptimize(last = std::set_intersection(lhs.cbegin(), lhs.cend(), rhs.cbegin(), rhs.cend(), out.data()));
+        }, items);
+        suite.Run("intersection/sorted_sets/" + name, [&]{
+            DoNotOptimize(last = SortedSets::Intersection(lhs.cbegin(), lhs.cend(), rhs.cbegin(), rhs.cend(), out.data()));
+        }, items);
+        check(last, "SortedSets::Intersection " + name);
+        suite.Run("intersection/partitioned/" + name, [&]{
+            DoNotOptimize(last = SortedSets::Intersection(policy, lhs.cbegin(), lhs.cend(), rhs.cbegin(), rhs.cend(), out.data()));
+        }, items);
+        check(last, "partitioned SortedSets::Intersection " + name);
+
+        expected.clear();
+        std::set_union(lhs.cbegin(), lhs.cend(), rhs.cbegin(), rhs.cend(), std::back_inserter(expected));
+        suite.Run("union/std/" + name, [&]{
+            DoNotOptimize(last = std::set_union(lhs.cbegin(), lhs.cend(), rhs.cbegin(), rhs.cend(), out.data()));
+        }, items);
+        suite.Run("union/partitioned/" + name, [&]{
+            DoNotOptimize(last = SortedSets::Union(policy, lhs.cbegin(), lhs.cend(), rhs.cbegin(), rhs.cend(), out.data()));
+        }, items);
+        check(last, "partitioned SortedSets::Union " + name);
+    }
+
+    //k lists: the long one, a tenth of it, 10^5 and 10^3, each half made of the one before
+    {
+        std::vector<Ids> lists{large};
+        for (size_t count: {large.size() / 10, size_t{100000}, size_t{1000}})
+        {
+            lists.push_back(MakeIds(rng, count, lists.back()));
+        }
+        std::reverse(std::begin(lists), std::end(lists));
+        using It = Ids::const_iterator;
+        std::vector<std::pair<It, It>> ranges;
+        for (auto const& list: lists)
+        {
+            ranges.emplace_back(list.cbegin(), list.cend());
+        }
+        uint32_t* last{nullptr};
+        Ids step;
+        Ids next;
+
+        suite.Run("intersect_all/std/4_lists", [&]{
+            step = lists[0];
+            for (auto list=lists.begin() + 1; list != lists.end(); ++list)
+            {
+                next.clear();
+                std::set_intersection(step.cbegin(), step.cend(), list->cbegin(), list->cend(), std::back_inserter(next));
+                std::swap(step, next);
+            }
+            DoNotOptimize(step.data());
+        }, large.size());
+        expected = step;
+        suite.Run("intersect_all/sorted_sets/4_lists", [&]{DoNotOptimize(last = SortedSets::IntersectAll(ranges, out.data()));}, large.size());
+        check(last, "SortedSets::IntersectAll");
+    }
+
+    pool.Stop();
+    return suite.Finish();
+}
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <random>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+
+#include "simd_search.h"
+#include "../Threading/bench.h"
+
+/**
+ * Cross-checks every SimdSearch kernel at every level against std on random inputs (all lengths and alignments up to
+ * a few vectors, so the tails are covered), then times them against std on large buffers and prints GB/s
+ */
+
+bool CrossCheck(BenchSuite& suite, size_t rounds)
+{
+    std::mt19937 rng{11};
+    std::vector<char> text(512);
+    std::vector<char> other(512);
+    std::vector<int> ints(128);
+    std::vector<int> otherInts(128);
+    std::vector<double> doubles(256);
+    for (auto round=0U; round < rounds; ++round)
+    {
+        auto size = rng() % 300;
+        auto offset = rng() % 32;
+        auto alphabet = 1 + rng() % 256;
+        auto first = text.data() + offset;
+        auto last = first + size;
+        std::generate(first, last, [&]{return static_cast<char>(rng() % alphabet);});
+        std::string members(rng() % 6, ' ');
+        std::generate(std::begin(members), std::end(members), [&]{return static_cast<char>(rng());});
+        std::copy(first, last, std::begin(other));
+        if (size != 0)
+        {
+            other[rng() % size] ^= 1 + rng() % 255;
+        }
+        auto intSize = size / 4;
+        std::generate(std::begin(ints), std::begin(ints) + intSize, [&]{return static_cast<int>(rng() % 3);});
+        std::copy(std::begin(ints), std::end(ints), std::begin(otherInts));
+        if (intSize != 0)
+        {
+            otherInts[rng() % intSize] += 1 << (rng() % 31);
+        }
+        std::generate(std::begin(doubles), std::end(doubles), [&]{return rng() % 7 == 0 ? NAN : (rng() % 1000) / 10.0;});
+        auto low = (rng() % 1000) / 10.0;
+        auto high = (rng() % 1000) / 10.0;
+
+        for (auto level: {SimdLevel::Scalar, SimdLevel::Sse42, SimdLevel::Avx2})
+        {
+            bool ok = SimdSearch::FindFirstOf(first, last, members.data(), members.data() + members.size(), level) ==
+                          std::find_first_of(first, last, std::cbegin(members), std::cend(members)) &&
+                      SimdSearch::AdjacentFind(first, last, level) == std::adjacent_find(first, last) &&
+                      SimdSearch::Mismatch<char>(first, last, other.data(), other.data() + size, level).first ==
+                          std::mismatch(first, last, other.data(), other.data() + size).first &&
+                      SimdSearch::Mismatch(ints.data(), ints.data() + intSize, otherInts.data(), otherInts.data() + intSize, level).first ==
+                          std::mismatch(ints.data(), ints.data() + intSize, otherInts.data(), otherInts.data() + intSize).first &&
+                      SimdSearch::CountInRange(doubles.data(), doubles.data() + size % 256, low, high, level) ==
+                          static_cast<size_t>(std::count_if(doubles.data(), doubles.data() + size % 256,
+                                                            [&](auto value){return value > low && value < high;}));
+            suite.Check(ok, std::string{"SimdSearch at "} + SimdLevelName(level) + ", round " + std::to_string(round));
+            if (!ok)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Takes the buffer size in bytes (default 10^8) and the number of cross-check rounds (default 10^5), and the
+ * options in bench.h
+ */
+int main(int argc, char* argv[])
+{
+    BenchSuite suite{"simd", argc, argv};
+    size_t bytes = suite.Arg(0, 100000000);
+    size_t rounds = suite.Arg(1, 100000);
+
+    if (!CrossCheck(suite, rounds))
+    {
+        return suite.Finish();
+    }
+    std::cout << "Cross-check passed, best level is " << SimdLevelName(SimdSearch::Detected()) << std::endl;
+
+    //the worst case for all the searches: what they look for is only at the very end
+    std::mt19937 rng{42};
+    std::string text(bytes, ' ');
+    for (auto idx=0U; idx < bytes; ++idx)
+    {
+        do
+        {
+            text[idx] = static_cast<char>('a' + rng() % 26);
+        } while (idx != 0 && text[idx] == text[idx - 1]);
+    }
+    text.back() = text[bytes - 2];
+    std::string almostText{text};
+    almostText.back() = '!';
+    std::string const separators{",;:!"};
+    ByteSet separatorSet{separators.data(), separators.data() + separators.size()};
+    auto first = text.data();
+    auto last = first + bytes;
+    std::vector<double> doubles(bytes / sizeof(double));
+    std::generate(std::begin(doubles), std::end(doubles), [&]{return (rng() % 100000) / 10.0;});
+
+    suite.Run("find_first_of/std", [&]{
+        DoNotOptimize(std::find_first_of(first, last, std::cbegin(separators), std::cend(separators)));
+    }, bytes);
+    suite.Run("adjacent_find/std", [&]{DoNotOptimize(std::adjacent_find(first, last));}, bytes);
+    suite.Run("mismatch/std", [&]{DoNotOptimize(std::mismatch(first, last, almostText.data(), almostText.data() + bytes));}, bytes);
+    suite.Run("count_in_range/std", [&]{
+        DoNotOptimize(std::count_if(std::cbegin(doubles), std::cend(doubles), [](auto value){return value > 2000.0 && value < 4000.0;}));
+    }, doubles.size() * sizeof(double));
+
+    for (auto level: {SimdLevel::Scalar, SimdLevel::Sse42, SimdLevel::Avx2})
+    {
+        if (level > SimdSearch::Detected())
+        {
+            continue;
+        }
+        std::string name{SimdLevelName(level)};
+        suite.Run("find_first_of/" + name, [&]{DoNotOptimize(SimdSearch::FindFirstOf(first, last, separatorSet, level));}, bytes);
+        suite.Run("adjacent_find/" + name, [&]{DoNotOptimize(SimdSearch::AdjacentFind(first, last, level));}, bytes);
+        suite.Run("mismatch/" + name, [&]{
+            DoNotOptimize(SimdSearch::Mismatch(first, last, almostText.data(), almostText.data() + bytes, level));
+        }, bytes);
+        suite.Run("count_in_range/" + name, [&]{
+            DoNotOptimize(SimdSearch::CountInRange(doubles.data(), doubles.data() + doubles.size(), 2000.0, 4000.0, level));
+        }, doubles.size() * sizeof(double));
+    }
+
+    //items are bytes, so items per ns is GB/s
+    std::cout << std::endl << std::left << std::setw(40) << "throughput" << std::right << std::setw(10) << "GB/s" << std::endl;
+    for (auto const& cur: suite.Results())
+    {
+        std::cout << std::left << std::setw(40) << cur.m_name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(10) << cur.m_items / cur.m_medianNs << std::endl;
+    }
+    return suite.Finish();
+}
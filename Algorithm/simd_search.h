@@ -0,0 +1,399 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <utility>
+#include <type_traits>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Vectorized versions of the scans algorithm.cpp does with find_first_of, adjacent_find, mismatch and count_if on a
+ * range of doubles. Every kernel has an AVX2, an SSE4.2 and a scalar version, compiled with per-function target
+ * attributes so nothing needs -mavx2, and picked at run time from what the CPU supports:
+ *
+ *     ByteSet separators{" ,;\t"};
+ *     auto word = SimdSearch::FindFirstOf(line, line + length, separators);
+ *
+ * A level can be passed to any of them to force a slower path (for testing), asking for more than the CPU has
+ * gets the best it does have.
+ */
+
+enum class SimdLevel
+{
+    Scalar,
+    Sse42,
+    Avx2
+};
+
+inline char const* SimdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::Avx2: return "avx2";
+    case SimdLevel::Sse42: return "sse42";
+    default: return "scalar";
+    }
+}
+
+/**
+ * A set of bytes, as a 256 entry table for the scalar code and as two 16 byte nibble tables for the shuffle lookup:
+ * bit h of m_low[b & 15] is set when (h << 4 | (b & 15)) is a member, for the high nibbles h 0-7, and m_high holds
+ * the same for 8-15.
+ */
+class ByteSet
+{
+public:
+    ByteSet() = delete;
+    template <typename It>
+    ByteSet(It first, It last)
+    {
+        for (; first != last; ++first)
+        {
+            auto byte = static_cast<uint8_t>(*first);
+            m_member[byte] = true;
+            (byte < 128 ? m_low : m_high)[byte & 15] |= static_cast<uint8_t>(1 << ((byte >> 4) & 7));
+        }
+    }
+    explicit ByteSet(char const* members) : ByteSet(members, members + std::char_traits<char>::length(members)) {}
+
+    bool Contains(uint8_t byte) const {return m_member[byte];}
+    uint8_t const* Low() const {return m_low;}
+    uint8_t const* High() const {return m_high;}
+
+private:
+    std::array<bool, 256> m_member{};
+    alignas(16) uint8_t m_low[16]{};
+    alignas(16) uint8_t m_high[16]{};
+};
+
+class SimdSearch
+{
+public:
+    /**
+     * The best level this CPU supports, detected once
+     */
+    static SimdLevel Detected()
+    {
+        static const SimdLevel level = Detect();
+        return level;
+    }
+
+    /**
+     * The first byte of [first, last) in set, or last
+     */
+    static char const* FindFirstOf(char const* first, char const* last, ByteSet const& set, SimdLevel level = Detected())
+    {
+        auto data = reinterpret_cast<uint8_t const*>(first);
+        size_t size = last - first;
+        switch (Clamp(level))
+        {
+#if defined(__x86_64__) || defined(__i386__)
+        case SimdLevel::Avx2: return first + FindFirstOfAvx2(data, size, set);
+        case SimdLevel::Sse42: return first + FindFirstOfSse42(data, size, set);
+#endif
+        default: return first + FindFirstOfScalar(data, size, set);
+        }
+    }
+
+    static char const* FindFirstOf(char const* first, char const* last, char const* setFirst, char const* setLast,
+                                   SimdLevel level = Detected())
+    {
+        return FindFirstOf(first, last, ByteSet{setFirst, setLast}, level);
+    }
+
+    /**
+     * The first of two equal neighbouring bytes, or last. Compares 32 (or 16) bytes with the same bytes shifted by
+     * one at a time.
+     */
+    static char const* AdjacentFind(char const* first, char const* last, SimdLevel level = Detected())
+    {
+        auto data = reinterpret_cast<uint8_t const*>(first);
+        size_t size = last - first;
+        switch (Clamp(level))
+        {
+#if defined(__x86_64__) || defined(__i386__)
+        case SimdLevel::Avx2: return first + AdjacentFindAvx2(data, size);
+        case SimdLevel::Sse42: return first + AdjacentFindSse42(data, size);
+#endif
+        default: return first + AdjacentFindScalar(data, size, 0);
+        }
+    }
+
+    /**
+     * The first position where the ranges differ, as std::mismatch. Integral T only: elements are compared bytewise,
+     * which is only the same as == when there is a single bit pattern per value.
+     */
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+    static std::pair<T const*, T const*> Mismatch(T const* first1, T const* last1, T const* first2, T const* last2,
+                                                  SimdLevel level = Detected())
+    {
+        size_t count = std::min(last1 - first1, last2 - first2);
+        auto lhs = reinterpret_cast<uint8_t const*>(first1);
+        auto rhs = reinterpret_cast<uint8_t const*>(first2);
+        size_t offset;
+        switch (Clamp(level))
+        {
+#if defined(__x86_64__) || defined(__i386__)
+        case SimdLevel::Avx2: offset = MismatchAvx2(lhs, rhs, count * sizeof(T)); break;
+        case SimdLevel::Sse42: offset = MismatchSse42(lhs, rhs, count * sizeof(T)); break;
+#endif
+        default: offset = MismatchScalar(lhs, rhs, count * sizeof(T), 0); break;
+        }
+        return {first1 + offset / sizeof(T), first2 + offset / sizeof(T)};
+    }
+
+    /**
+     * How many values lie strictly between low and high (NaNs never do)
+     */
+    static size_t CountInRange(double const* first, double const* last, double low, double high, SimdLevel level = Detected())
+    {
+        size_t size = last - first;
+        switch (Clamp(level))
+        {
+#if defined(__x86_64__) || defined(__i386__)
+        case SimdLevel::Avx2: return CountInRangeAvx2(first, size, low, high);
+        case SimdLevel::Sse42: return CountInRangeSse42(first, size, low, high);
+#endif
+        default: return CountInRangeScalar(first, size, low, high);
+        }
+    }
+
+private:
+    static SimdLevel Detect()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return SimdLevel::Avx2;
+        }
+        if (__builtin_cpu_supports("sse4.2"))
+        {
+            return SimdLevel::Sse42;
+        }
+#endif
+        return SimdLevel::Scalar;
+    }
+
+    static SimdLevel Clamp(SimdLevel level)
+    {
+        return std::min(level, Detected());
+    }
+
+    static size_t FindFirstOfScalar(uint8_t const* data, size_t size, ByteSet const& set)
+    {
+        size_t idx{0};
+        while (idx < size && !set.Contains(data[idx]))
+        {
+            ++idx;
+        }
+        return idx;
+    }
+
+    static size_t AdjacentFindScalar(uint8_t const* data, size_t size, size_t idx)
+    {
+        for (; idx + 1 < size; ++idx)
+        {
+            if (data[idx] == data[idx + 1])
+            {
+                return idx;
+            }
+        }
+        return size;
+    }
+
+    static size_t MismatchScalar(uint8_t const* lhs, uint8_t const* rhs, size_t size, size_t idx)
+    {
+        while (idx < size && lhs[idx] == rhs[idx])
+        {
+            ++idx;
+        }
+        return idx;
+    }
+
+    static size_t CountInRangeScalar(double const* data, size_t size, double low, double high)
+    {
+        size_t count{0};
+        for (size_t idx=0; idx < size; ++idx)
+        {
+            count += (data[idx] > low && data[idx] < high) ? 1 : 0;
+        }
+        return count;
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    /**
+     * Membership of 32 bytes at once: the low nibble of each byte picks its row from both nibble tables (pshufb), the
+     * high nibble picks the table and, through a third lookup, the bit within the row
+     */
+    __attribute__((target("avx2")))
+    static size_t FindFirstOfAvx2(uint8_t const* data, size_t size, ByteSet const& set)
+    {
+        auto low = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<__m128i const*>(set.Low())));
+        auto high = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<__m128i const*>(set.High())));
+        auto bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+                                     1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+        auto nibble = _mm256_set1_epi8(0x0f);
+        size_t idx{0};
+        for (; idx + 32 <= size; idx += 32)
+        {
+            auto chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data + idx));
+            auto lo = _mm256_and_si256(chunk, nibble);
+            auto hi = _mm256_and_si256(_mm256_srli_epi16(chunk, 4), nibble);
+            //blendv takes the top bit of each byte, bit 3 of hi (the high table) shifted up to it
+            auto row = _mm256_blendv_epi8(_mm256_shuffle_epi8(low, lo), _mm256_shuffle_epi8(high, lo), _mm256_slli_epi16(hi, 4));
+            auto bit = _mm256_shuffle_epi8(bits, hi);
+            auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit)));
+            if (mask != 0)
+            {
+                return idx + __builtin_ctz(mask);
+            }
+        }
+        return idx + FindFirstOfScalar(data + idx, size - idx, set);
+    }
+
+    __attribute__((target("sse4.2")))
+    static size_t FindFirstOfSse42(uint8_t const* data, size_t size, ByteSet const& set)
+    {
+        auto low = _mm_load_si128(reinterpret_cast<__m128i const*>(set.Low()));
+        auto high = _mm_load_si128(reinterpret_cast<__m128i const*>(set.High()));
+        auto bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+        auto nibble = _mm_set1_epi8(0x0f);
+        size_t idx{0};
+        for (; idx + 16 <= size; idx += 16)
+        {
+            auto chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + idx));
+            auto lo = _mm_and_si128(chunk, nibble);
+            auto hi = _mm_and_si128(_mm_srli_epi16(chunk, 4), nibble);
+            auto row = _mm_blendv_epi8(_mm_shuffle_epi8(low, lo), _mm_shuffle_epi8(high, lo), _mm_slli_epi16(hi, 4));
+            auto bit = _mm_shuffle_epi8(bits, hi);
+            auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(row, bit), bit)));
+            if (mask != 0)
+            {
+                return idx + __builtin_ctz(mask);
+            }
+        }
+        return idx + FindFirstOfScalar(data + idx, size - idx, set);
+    }
+
+    __attribute__((target("avx2")))
+    static size_t AdjacentFindAvx2(uint8_t const* data, size_t size)
+    {
+        size_t idx{0};
+        for (; idx + 33 <= size; idx += 32)
+        {
+            auto here = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data + idx));
+            auto next = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data + idx + 1));
+            auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(here, next)));
+            if (mask != 0)
+            {
+                return idx + __builtin_ctz(mask);
+            }
+        }
+        return AdjacentFindScalar(data, size, idx);
+    }
+
+    __attribute__((target("sse4.2")))
+    static size_t AdjacentFindSse42(uint8_t const* data, size_t size)
+    {
+        size_t idx{0};
+        for (; idx + 17 <= size; idx += 16)
+        {
+            auto here = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + idx));
+            auto next = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + idx + 1));
+            auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(here, next)));
+            if (mask != 0)
+            {
+                return idx + __builtin_ctz(mask);
+            }
+        }
+        return AdjacentFindScalar(data, size, idx);
+    }
+
+    __attribute__((target("avx2")))
+    static size_t MismatchAvx2(uint8_t const* lhs, uint8_t const* rhs, size_t size)
+    {
+        size_t idx{0};
+        for (; idx + 32 <= size; idx += 32)
+        {
+            auto equal = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(lhs + idx)),
+                                           _mm256_loadu_si256(reinterpret_cast<__m256i const*>(rhs + idx)));
+            auto mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(equal));
+            if (mask != 0)
+            {
+                return idx + __builtin_ctz(mask);
+            }
+        }
+        return MismatchScalar(lhs, rhs, size, idx);
+    }
+
+    __attribute__((target("sse4.2")))
+    static size_t MismatchSse42(uint8_t const* lhs, uint8_t const* rhs, size_t size)
+    {
+        size_t idx{0};
+        for (; idx + 16 <= size; idx += 16)
+        {
+            auto equal = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(lhs + idx)),
+                                        _mm_loadu_si128(reinterpret_cast<__m128i const*>(rhs + idx)));
+            auto mask = static_cast<uint32_t>(_mm_movemask_epi8(equal)) ^ 0xffffU;
+            if (mask != 0)
+            {
+                return idx + __builtin_ctz(mask);
+            }
+        }
+        return MismatchScalar(lhs, rhs, size, idx);
+    }
+
+    /**
+     * Each in range lane is all ones, i.e. -1 as an integer, so subtracting the comparison counts it. Two accumulators
+     * keep two chains in flight.
+     */
+    __attribute__((target("avx2")))
+    static size_t CountInRangeAvx2(double const* data, size_t size, double low, double high)
+    {
+        auto lo = _mm256_set1_pd(low);
+        auto hi = _mm256_set1_pd(high);
+        auto count0 = _mm256_setzero_si256();
+        auto count1 = _mm256_setzero_si256();
+        size_t idx{0};
+        for (; idx + 8 <= size; idx += 8)
+        {
+            auto values0 = _mm256_loadu_pd(data + idx);
+            auto values1 = _mm256_loadu_pd(data + idx + 4);
+            auto in0 = _mm256_and_pd(_mm256_cmp_pd(values0, lo, _CMP_GT_OQ), _mm256_cmp_pd(values0, hi, _CMP_LT_OQ));
+            auto in1 = _mm256_and_pd(_mm256_cmp_pd(values1, lo, _CMP_GT_OQ), _mm256_cmp_pd(values1, hi, _CMP_LT_OQ));
+            count0 = _mm256_sub_epi64(count0, _mm256_castpd_si256(in0));
+            count1 = _mm256_sub_epi64(count1, _mm256_castpd_si256(in1));
+        }
+        alignas(32) uint64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(count0, count1));
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3] + CountInRangeScalar(data + idx, size - idx, low, high);
+    }
+
+    __attribute__((target("sse4.2")))
+    static size_t CountInRangeSse42(double const* data, size_t size, double low, double high)
+    {
+        auto lo = _mm_set1_pd(low);
+        auto hi = _mm_set1_pd(high);
+        auto count0 = _mm_setzero_si128();
+        auto count1 = _mm_setzero_si128();
+        size_t idx{0};
+        for (; idx + 4 <= size; idx += 4)
+        {
+            auto values0 = _mm_loadu_pd(data + idx);
+            auto values1 = _mm_loadu_pd(data + idx + 2);
+            count0 = _mm_sub_epi64(count0, _mm_castpd_si128(_mm_and_pd(_mm_cmpgt_pd(values0, lo), _mm_cmplt_pd(values0, hi))));
+            count1 = _mm_sub_epi64(count1, _mm_castpd_si128(_mm_and_pd(_mm_cmpgt_pd(values1, lo), _mm_cmplt_pd(values1, hi))));
+        }
+        alignas(16) uint64_t lanes[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), _mm_add_epi64(count0, count1));
+        return lanes[0] + lanes[1] + CountInRangeScalar(data + idx, size - idx, low, high);
+    }
+#endif
+};
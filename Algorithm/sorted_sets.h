@@ -0,0 +1,419 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <cstdint>
+
+#include "parallel_algorithm.h"
+#include "simd_search.h"
+
+/**
+ * std::set_intersection, set_union, set_difference, set_symmetric_difference and includes for sorted lists of very
+ * different sizes, e.g. a few thousand IDs against hundreds of millions. Each takes the same arguments and writes the
+ * same output (duplicates included) as its std counterpart, and picks how to get there:
+ *  - when one list is at least GallopRatio times the shorter, the short one is walked and every element is looked
+ *    up in the long one by galloping (doubling steps from the last position, then a binary search), so the cost
+ *    grows with the short list times the log of the gap instead of with the long list. Stretches of the long list
+ *    that are only copied (union, difference) are copied in bulk.
+ *  - an intersection of two similar, contiguous lists of 32 bit integers with the default order runs an AVX2 all
+ *    pairs compare of 8 elements against 8 (when the CPU has it). The other operations have to write both lists'
+ *    elements in merged order, which an all pairs compare doesn't give, so they stay on the merge.
+ *  - anything else goes to the std algorithm, which is a linear merge already
+ *
+ * IntersectAll intersects k lists, and the overloads taking a ParallelPolicy cut both lists at the same values and
+ * run the pieces on the pool.
+ */
+class SortedSets
+{
+public:
+    static constexpr size_t GallopRatio{32};
+
+    template <typename It1, typename It2, typename OutIt, typename Compare = std::less<>>
+    static OutIt Intersection(It1 first1, It1 last1, It2 first2, It2 last2, OutIt out, Compare comp = {})
+    {
+        size_t size1 = std::distance(first1, last1);
+        size_t size2 = std::distance(first2, last2);
+        if (size2 >= size1 * GallopRatio)
+        {
+            return GallopIntersection(first1, last1, first2, last2, out, comp, true);
+        }
+        if (size1 >= size2 * GallopRatio)
+        {
+            return GallopIntersection(first2, last2, first1, last1, out, comp, false);
+        }
+#if defined(__x86_64__) || defined(__i386__)
+        if constexpr (Simd32<It1, It2, Compare>)
+        {
+            if (SimdSearch::Detected() >= SimdLevel::Avx2)
+            {
+                return IntersectionAvx2(&*first1, size1, &*first2, size2, out);
+            }
+        }
+#endif
+        return std::set_intersection(first1, last1, first2, last2, out, comp);
+    }
+
+    template <typename It1, typename It2, typename OutIt, typename Compare = std::less<>>
+    static OutIt Union(It1 first1, It1 last1, It2 first2, It2 last2, OutIt out, Compare comp = {})
+    {
+        size_t size1 = std::distance(first1, last1);
+        size_t size2 = std::distance(first2, last2);
+        if (size2 >= size1 * GallopRatio)
+        {
+            return GallopMerge(first1, last1, first2, last2, out, comp, true, true, true, true);
+        }
+        if (size1 >= size2 * GallopRatio)
+        {
+            return GallopMerge(first2, last2, first1, last1, out, comp, false, true, true, true);
+        }
+        return std::set_union(first1, last1, first2, last2, out, comp);
+    }
+
+    template <typename It1, typename It2, typename OutIt, typename Compare = std::less<>>
+    static OutIt Difference(It1 first1, It1 last1, It2 first2, It2 last2, OutIt out, Compare comp = {})
+    {
+        size_t size1 = std::distance(first1, last1);
+        size_t size2 = std::distance(first2, last2);
+        if (size2 >= size1 * GallopRatio)
+        {
+            return GallopMerge(first1, last1, first2, last2, out, comp, true, true, false, false);
+        }
+        if (size1 >= size2 * GallopRatio)
+        {
+            return GallopMerge(first2, last2, first1, last1, out, comp, false, false, true, false);
+        }
+        return std::set_difference(first1, last1, first2, last2, out, comp);
+    }
+
+    template <typename It1, typename It2, typename OutIt, typename Compare = std::less<>>
+    static OutIt SymmetricDifference(It1 first1, It1 last1, It2 first2, It2 last2, OutIt out, Compare comp = {})
+    {
+        size_t size1 = std::distance(first1, last1);
+        size_t size2 = std::distance(first2, last2);
+        if (size2 >= size1 * GallopRatio)
+        {
+            return GallopMerge(first1, last1, first2, last2, out, comp, true, true, true, false);
+        }
+        if (size1 >= size2 * GallopRatio)
+        {
+            return GallopMerge(first2, last2, first1, last1, out, comp, false, true, true, false);
+        }
+        return std::set_symmetric_difference(first1, last1, first2, last2, out, comp);
+    }
+
+    /**
+     * True if every element of [first2, last2) is in [first1, last1), as often as it is there
+     */
+    template <typename It1, typename It2, typename Compare = std::less<>>
+    static bool Includes(It1 first1, It1 last1, It2 first2, It2 last2, Compare comp = {})
+    {
+        size_t size1 = std::distance(first1, last1);
+        size_t size2 = std::distance(first2, last2);
+        if (size2 > size1)
+        {
+            return false;
+        }
+        if (size1 < size2 * GallopRatio)
+        {
+            return std::includes(first1, last1, first2, last2, comp);
+        }
+        for (; first2 != last2; ++first2)
+        {
+            first1 = Gallop(first1, last1, *first2, comp);
+            if (first1 == last1 || comp(*first2, *first1))
+            {
+                return false;
+            }
+            ++first1;
+        }
+        return true;
+    }
+
+    /**
+     * The elements common to every one of the sorted ranges in lists (as often as the least of them has each), taken
+     * from the shortest range. That range is walked, and every element is galloped to in all the others, shortest
+     * first, so a miss is usually found in the list most likely to have it.
+     */
+    template <typename It, typename OutIt, typename Compare = std::less<>>
+    static OutIt IntersectAll(std::vector<std::pair<It, It>> lists, OutIt out, Compare comp = {})
+    {
+        if (lists.empty())
+        {
+            return out;
+        }
+        std::sort(lists.begin(), lists.end(), [](auto const& lhs, auto const& rhs) {
+            return std::distance(lhs.first, lhs.second) < std::distance(rhs.first, rhs.second);
+        });
+        for (auto cur=lists[0].first; cur != lists[0].second; ++cur)
+        {
+            bool everywhere{true};
+            for (auto list=lists.begin() + 1; list != lists.end() && everywhere; ++list)
+            {
+                list->first = Gallop(list->first, list->second, *cur, comp);
+                everywhere = list->first != list->second && !comp(*cur, *list->first);
+            }
+            if (!everywhere)
+            {
+                continue;
+            }
+            *out++ = *cur;
+            for (auto list=lists.begin() + 1; list != lists.end(); ++list)
+            {
+                ++list->first; //each match uses up one copy in every list
+            }
+        }
+        return out;
+    }
+
+    /**
+     * The parallel versions: the longer list is cut into a few blocks per worker, each cut moved back to the start of
+     * its run of equal elements and found in the shorter list with a binary search, so every pair of pieces holds
+     * all the copies of the values in it. The pieces are worked on the pool into buffers of their own, which are then
+     * copied to out in order, so out can be any output iterator.
+     */
+    template <typename Pool, typename It1, typename It2, typename OutIt, typename Compare = std::less<>>
+    static OutIt Intersection(ParallelPolicy<Pool> const& policy, It1 first1, It1 last1, It2 first2, It2 last2, OutIt out, Compare comp = {})
+    {
+        return Partitioned(policy, first1, last1, first2, last2, out, comp, [&](auto... args) {return Intersection(args..., comp);});
+    }
+
+    template <typename Pool, typename It1, typename It2, typename OutIt, typename Compare = std::less<>>
+    static OutIt Union(ParallelPolicy<Pool> const& policy, It1 first1, It1 last1, It2 first2, It2 last2, OutIt out, Compare comp = {})
+    {
+        return Partitioned(policy, first1, last1, first2, last2, out, comp, [&](auto... args) {return Union(args..., comp);});
+    }
+
+    template <typename Pool, typename It1, typename It2, typename OutIt, typename Compare = std::less<>>
+    static OutIt Difference(ParallelPolicy<Pool> const& policy, It1 first1, It1 last1, It2 first2, It2 last2, OutIt out, Compare comp = {})
+    {
+        return Partitioned(policy, first1, last1, first2, last2, out, comp, [&](auto... args) {return Difference(args..., comp);});
+    }
+
+    template <typename Pool, typename It1, typename It2, typename OutIt, typename Compare = std::less<>>
+    static OutIt SymmetricDifference(ParallelPolicy<Pool> const& policy, It1 first1, It1 last1, It2 first2, It2 last2, OutIt out,
+                                     Compare comp = {})
+    {
+        return Partitioned(policy, first1, last1, first2, last2, out, comp,
+                           [&](auto... args) {return SymmetricDifference(args..., comp);});
+    }
+
+private:
+    template <typename It>
+    using Value = typename std::iterator_traits<It>::value_type;
+
+    template <typename It>
+    static constexpr bool Contiguous = std::is_pointer_v<It> || std::is_same_v<It, typename std::vector<Value<It>>::iterator> ||
+                                       std::is_same_v<It, typename std::vector<Value<It>>::const_iterator>;
+
+    template <typename It>
+    static constexpr bool Int32 = std::is_same_v<Value<It>, int32_t> || std::is_same_v<Value<It>, uint32_t>;
+
+    /**
+     * Whether the AVX2 intersection applies: contiguous 32 bit integers of the same type, in the default order
+     */
+    template <typename It1, typename It2, typename Compare>
+    static constexpr bool Simd32 = Contiguous<It1> && Contiguous<It2> && Int32<It1> && std::is_same_v<Value<It1>, Value<It2>> &&
+                                   (std::is_same_v<Compare, std::less<>> || std::is_same_v<Compare, std::less<Value<It1>>>);
+
+    /**
+     * std::lower_bound(first, last, value), trying first + 1, + 3, + 7... before the binary search, so finding a
+     * value near first is cheap
+     */
+    template <typename It, typename T, typename Compare>
+    static It Gallop(It first, It last, T const& value, Compare& comp)
+    {
+        size_t remaining = std::distance(first, last);
+        size_t lo{0};
+        size_t step{1};
+        while (step <= remaining && comp(*std::next(first, step - 1), value))
+        {
+            lo = step;
+            step *= 2;
+        }
+        auto begin = std::next(first, lo);
+        return std::lower_bound(begin, std::next(first, std::min(step, remaining)), value, comp);
+    }
+
+    /**
+     * Intersection with the short list walked and galloped to in the long one. shortIsFirst says which of them is the
+     * std algorithm's first range, whose elements are the ones written.
+     */
+    template <typename ItS, typename ItL, typename OutIt, typename Compare>
+    static OutIt GallopIntersection(ItS first, ItS last, ItL longFirst, ItL longLast, OutIt out, Compare& comp, bool shortIsFirst)
+    {
+        for (; first != last && longFirst != longLast; ++first)
+        {
+            longFirst = Gallop(longFirst, longLast, *first, comp);
+            if (longFirst != longLast && !comp(*first, *longFirst))
+            {
+                if (shortIsFirst)
+                {
+                    *out++ = *first;
+                }
+                else
+                {
+                    *out++ = *longFirst;
+                }
+                ++longFirst;
+            }
+        }
+        return out;
+    }
+
+    /**
+     * The other three operations, walking the short list and galloping in the long one. Every short element is
+     * either unmatched or paired with one copy in the long list; the flags say what is written for each case:
+     * keepShort (unmatched short elements), keepLong (unmatched long elements, copied a stretch at a time), and
+     * keepMatched (one of a matched pair, from the std algorithm's first range).
+     */
+    template <typename ItS, typename ItL, typename OutIt, typename Compare>
+    static OutIt GallopMerge(ItS first, ItS last, ItL longFirst, ItL longLast, OutIt out, Compare& comp, bool shortIsFirst,
+                             bool keepShort, bool keepLong, bool keepMatched)
+    {
+        for (; first != last; ++first)
+        {
+            auto found = Gallop(longFirst, longLast, *first, comp);
+            if (keepLong)
+            {
+                out = std::copy(longFirst, found, out);
+            }
+            longFirst = found;
+            if (longFirst != longLast && !comp(*first, *longFirst))
+            {
+                if (keepMatched)
+                {
+                    if (shortIsFirst)
+                    {
+                        *out++ = *first;
+                    }
+                    else
+                    {
+                        *out++ = *longFirst;
+                    }
+                }
+                ++longFirst;
+            }
+            else if (keepShort)
+            {
+                *out++ = *first;
+            }
+        }
+        if (keepLong)
+        {
+            out = std::copy(longFirst, longLast, out);
+        }
+        return out;
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    /**
+     * All pairs: 8 elements of each list are compared 8 ways (the second block rotated a lane at a time), the matches
+     * in the first block are written, and whichever block ends lower (or both) is moved on. That is only right when
+     * neither block repeats a value, including with the element after it, so a block pair that does is done with
+     * the scalar merge instead.
+     */
+    template <typename T, typename OutIt>
+    __attribute__((target("avx2")))
+    static OutIt IntersectionAvx2(T const* lhs, size_t lhsSize, T const* rhs, size_t rhsSize, OutIt out)
+    {
+        auto rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+        size_t lo{0};
+        size_t ro{0};
+        while (lo + 9 <= lhsSize && ro + 9 <= rhsSize)
+        {
+            auto left = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(lhs + lo));
+            auto right = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(rhs + ro));
+            auto repeats = _mm256_or_si256(_mm256_cmpeq_epi32(left, _mm256_loadu_si256(reinterpret_cast<__m256i const*>(lhs + lo + 1))),
+                                           _mm256_cmpeq_epi32(right, _mm256_loadu_si256(reinterpret_cast<__m256i const*>(rhs + ro + 1))));
+            if (!_mm256_testz_si256(repeats, repeats))
+            {
+                for (auto loStop = lo + 8, roStop = ro + 8; lo < loStop && ro < roStop; )
+                {
+                    if (lhs[lo] < rhs[ro])
+                    {
+                        ++lo;
+                    }
+                    else if (rhs[ro] < lhs[lo])
+                    {
+                        ++ro;
+                    }
+                    else
+                    {
+                        *out++ = lhs[lo++];
+                        ++ro;
+                    }
+                }
+                continue;
+            }
+
+            auto matches = _mm256_cmpeq_epi32(left, right);
+            for (auto lane=1; lane < 8; ++lane)
+            {
+                right = _mm256_permutevar8x32_epi32(right, rotate);
+                matches = _mm256_or_si256(matches, _mm256_cmpeq_epi32(left, right));
+            }
+            for (auto mask = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(matches))); mask != 0; mask &= mask - 1)
+            {
+                *out++ = lhs[lo + __builtin_ctz(mask)];
+            }
+            auto leftMax = lhs[lo + 7];
+            auto rightMax = rhs[ro + 7];
+            if (!(rightMax < leftMax))
+            {
+                lo += 8;
+            }
+            if (!(leftMax < rightMax))
+            {
+                ro += 8;
+            }
+        }
+        return std::set_intersection(lhs + lo, lhs + lhsSize, rhs + ro, rhs + rhsSize, out);
+    }
+#endif
+
+    template <typename Pool, typename It1, typename It2, typename OutIt, typename Compare, typename Op>
+    static OutIt Partitioned(ParallelPolicy<Pool> const& policy, It1 first1, It1 last1, It2 first2, It2 last2, OutIt out,
+                             Compare& comp, Op op)
+    {
+        size_t size1 = std::distance(first1, last1);
+        size_t size2 = std::distance(first2, last2);
+        auto blocks = policy.Blocks(std::max(size1, size2));
+        if (blocks == 1)
+        {
+            return op(first1, last1, first2, last2, out);
+        }
+
+        //cuts[block] is where block starts in each list, the cut values come from the longer one
+        std::vector<std::pair<size_t, size_t>> cuts(blocks + 1, {size1, size2});
+        cuts[0] = {0, 0};
+        policy.ForEachIndex(blocks - 1, [&](size_t idx) {
+            auto block = idx + 1;
+            if (size1 >= size2)
+            {
+                auto cut = std::lower_bound(first1, last1, *std::next(first1, block * size1 / blocks), comp);
+                cuts[block] = {std::distance(first1, cut), std::distance(first2, std::lower_bound(first2, last2, *cut, comp))};
+            }
+            else
+            {
+                auto cut = std::lower_bound(first2, last2, *std::next(first2, block * size2 / blocks), comp);
+                cuts[block] = {std::distance(first1, std::lower_bound(first1, last1, *cut, comp)), std::distance(first2, cut)};
+            }
+        });
+
+        std::vector<std::vector<Value<It1>>> pieces(blocks);
+        policy.ForEachIndex(blocks, [&](size_t block) {
+            auto [lo1, lo2] = cuts[block];
+            auto [hi1, hi2] = cuts[block + 1];
+            op(std::next(first1, lo1), std::next(first1, hi1), std::next(first2, lo2), std::next(first2, hi2), std::back_inserter(pieces[block]));
+        });
+        for (auto const& piece: pieces)
+        {
+            out = std::copy(piece.begin(), piece.end(), out);
+        }
+        return out;
+    }
+};
@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <string>
+#include <random>
+#include <thread>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+#include <cstdlib>
+
+#include <unistd.h>
+
+#include "substring_search.h"
+#include "parallel_algorithm.h"
+#include "../Threading/thread_pool.h"
+#include "../Threading/bench.h"
+
+/**
+ * Times the substring searches against std::search, std::boyer_moore_horspool_searcher and std::find_end on a
+ * generated log, then a pattern set with AhoCorasick against one Searcher pass per pattern, and TextSearch::FindAll
+ * over the log written to a file and mapped. Prints GB/s.
+ */
+
+std::string MakeLog(std::mt19937_64& rng, size_t bytes)
+{
+    std::vector<std::string> const words{"GET", "POST", "/api/v1/items", "/login", "200", "404", "500", "user", "session",
+                                         "request", "served", "in", "ms", "cache", "hit", "miss", "worker", "INFO", "WARN"};
+    std::string log;
+    log.reserve(bytes + 64);
+    while (log.size() < bytes)
+    {
+        log += std::to_string(1600000000 + rng() % 100000000);
+        for (auto count=5 + rng() % 8; count > 0; --count)
+        {
+            log += ' ';
+            log += (rng() % 4 == 0) ? std::to_string(rng() % 100000) : words[rng() % words.size()];
+        }
+        log += '\n';
+    }
+    log.resize(bytes);
+    return log;
+}
+
+/**
+ * Takes the log size in bytes (default 2^28), the threads (default one per hardware thread), and the options in
+ * bench.h
+ */
+int main(int argc, char* argv[])
+{
+    BenchSuite suite{"substring", argc, argv};
+    size_t bytes = suite.Arg(0, size_t{1} << 28);
+    size_t threads = suite.Arg(1, std::max(1U, std::thread::hardware_concurrency()));
+
+    ThreadPool pool{threads};
+    pool.Start();
+    ParallelPolicy policy{pool};
+
+    std::mt19937_64 rng{42};
+    auto log = MakeLog(rng, bytes);
+    std::string const needle{"connection reset by peer"};
+    log.replace(bytes - needle.size() - 1, needle.size(), needle); //only at the very end, so every search reads it all
+    auto first = log.data();
+    auto last = first + log.size();
+    auto expected = last - needle.size() - 1;
+
+    //single pattern, forwards
+    char const* found{nullptr};
+    suite.Run("search/std", [&]{DoNotOptimize(found = std::search(first, last, needle.cbegin(), needle.cend()));}, bytes);
+    suite.Check(found == expected, "std::search");
+    std::boyer_moore_horspool_searcher stdHorspool{needle.cbegin(), needle.cend()};
+    suite.Run("search/std_horspool", [&]{DoNotOptimize(found = std::search(first, last, stdHorspool));}, bytes);
+    Horspool horspool{needle.data(), needle.data() + needle.size()};
+    suite.Run("search/horspool", [&]{DoNotOptimize(found = horspool.Find(first, last));}, bytes);
+    suite.Check(found == expected, "Horspool::Find");
+    TwoWay twoWay{needle.data(), needle.data() + needle.size()};
+    suite.Run("search/two_way", [&]{DoNotOptimize(found = twoWay.Find(first, last));}, bytes);
+    suite.Check(found == expected, "TwoWay::Find");
+    for (auto level: {SimdLevel::Scalar, SimdLevel::Sse42, SimdLevel::Avx2})
+    {
+        if (level > SimdSearch::Detected())
+        {
+            continue;
+        }
+        Searcher searcher{needle, level};
+        suite.Run(std::string{"search/searcher_"} + SimdLevelName(level), [&]{DoNotOptimize(found = searcher.Find(first, last));}, bytes);
+        suite.Check(found == expected, std::string{"Searcher::Find at "} + SimdLevelName(level));
+    }
+
+    //single pattern, backwards: it is only at the start
+    std::string const head{log.substr(0, 24)};
+    auto firstHead = std::search(first + 1, last, head.cbegin(), head.cend()) == last;
+    suite.Run("find_end/std", [&]{DoNotOptimize(found = std::find_end(first, last, head.cbegin(), head.cend()));}, bytes);
+    suite.Check(!firstHead || found == first, "std::find_end");
+    Searcher headSearcher{head};
+    suite.Run("find_end/searcher", [&]{DoNotOptimize(found = headSearcher.FindLast(first, last));}, bytes);
+    suite.Check(found == std::find_end(first, last, head.cbegin(), head.cend()), "Searcher::FindLast");
+
+    //the worst case for the filter and Horspool: the first and last bytes match everywhere
+    {
+        std::string repeats(bytes / 64, 'a');
+        std::string pattern(64, 'a');
+        pattern[32] = 'b';
+        repeats.replace(repeats.size() - pattern.size(), pattern.size(), pattern); //only at the end
+        auto repeatsFirst = repeats.data();
+        auto repeatsLast = repeatsFirst + repeats.size();
+        suite.Run("repeats/std", [&]{DoNotOptimize(found = std::search(repeatsFirst, repeatsLast, pattern.cbegin(), pattern.cend()));},
+                  repeats.size());
+        Searcher searcher{pattern};
+        suite.Run("repeats/searcher", [&]{DoNotOptimize(found = searcher.Find(repeatsFirst, repeatsLast));}, repeats.size());
+        suite.Check(found == repeatsLast - pattern.size(), "Searcher::Find on repeats");
+    }
+
+    //64 patterns: one AhoCorasick pass against one Searcher pass per pattern
+    std::vector<std::string> patterns{"POST /login 500", "session miss", "WARN worker", "404 user", "cache miss 500",
+                                            "GET /api/v1/items 404", "served in 999", needle, "hit hit hit", "INFO INFO",
+                                            "request 12345", "ms ms", "POST POST", "/login /login", "500 500 500", "miss WARN"};
+    std::vector<std::string> const pairs{"GET", "POST", "user", "cache", "WARN", "worker", "404", "500"};
+    for (auto const& lhs: pairs)
+    {
+        for (auto const& rhs: {"request", "session", "hit", "miss", "served", "ms"})
+        {
+            patterns.push_back(lhs + " " + rhs);
+        }
+    }
+    AhoCorasick automaton{patterns};
+    size_t matches{0};
+    suite.Run("patterns/searcher_each", [&]{
+        matches = 0;
+        for (auto const& pattern: patterns)
+        {
+            Searcher{pattern}.ForEachMatch(first, last, [&](size_t, size_t) {++matches;});
+        }
+        DoNotOptimize(matches);
+    }, bytes);
+    auto expectedMatches = matches;
+    suite.Run("patterns/aho_corasick", [&]{
+        matches = 0;
+        automaton.ForEachMatch(first, last, [&](size_t, size_t) {++matches;});
+        DoNotOptimize(matches);
+    }, bytes);
+    suite.Check(matches == expectedMatches, "AhoCorasick against Searcher, " + std::to_string(expectedMatches) + " matches");
+
+    //the same from a mapped file, a block per task
+    char path[] = "/tmp/substring_benchXXXXXX";
+    auto fd = mkstemp(path);
+    if (fd >= 0)
+    {
+        ::close(fd);
+        std::ofstream{path, std::ios::binary}.write(first, log.size());
+        {
+            auto file = MappedFile::Open(path);
+            std::vector<TextMatch> all;
+            suite.Run("file/searcher", [&]{all = TextSearch::FindAll(policy, file.Begin(), file.End(), Searcher{needle});}, bytes);
+            suite.Check(all.size() == 1 && all[0].m_offset == static_cast<size_t>(expected - first), "TextSearch::FindAll with a Searcher");
+            suite.Run("file/aho_corasick", [&]{all = TextSearch::FindAll(policy, file.Begin(), file.End(), automaton);}, bytes);
+            suite.Check(all.size() == expectedMatches && std::is_sorted(all.cbegin(), all.cend()), "TextSearch::FindAll with AhoCorasick");
+        }
+        std::remove(path);
+    }
+    pool.Stop();
+
+    //items are bytes, so items per ns is GB/s
+    std::cout << std::endl << std::left << std::setw(40) << "throughput" << std::right << std::setw(10) << "GB/s" << std::endl;
+    for (auto const& cur: suite.Results())
+    {
+        std::cout << std::left << std::setw(40) << cur.m_name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(10) << cur.m_items / cur.m_medianNs << std::endl;
+    }
+    return suite.Finish();
+}
@@ -0,0 +1,663 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "parallel_algorithm.h"
+#include "simd_search.h"
+
+/**
+ * Substring search for big buffers, instead of the O(nm) std::search and std::find_end algorithm.cpp uses:
+ *
+ *     Searcher searcher{"connection reset"};
+ *     auto hit = searcher.Find(text, text + size);        //std::search
+ *     auto lastHit = searcher.FindLast(text, text + size); //std::find_end
+ *
+ *     AhoCorasick patterns{{"timeout", "refused", "reset by peer"}};
+ *     auto file = MappedFile::Open("server.log");
+ *     auto matches = TextSearch::FindAll(policy, file.Begin(), file.End(), patterns);
+ *
+ * Horspool and TwoWay are the single pattern algorithms and can be used on their own; Searcher picks between them
+ * and the SIMD filter. Everything works on bytes, with the same results (and the same empty pattern rules) as the
+ * std algorithm it replaces.
+ */
+
+/**
+ * Boyer-Moore-Horspool: compare the last byte of the window, and on a mismatch (or after checking a candidate) shift by
+ * how far that byte is from the end of the pattern. Sublinear on text with a big alphabet, but O(nm) at worst.
+ * FindLast is the mirror image, comparing the first byte and shifting towards the start.
+ */
+class Horspool
+{
+public:
+    /**
+     * How far verification may run ahead of the scan before Find gives up (when asked to)
+     */
+    static constexpr size_t VerifySlack{4096};
+
+    Horspool() = delete;
+    Horspool(char const* first, char const* last) : m_pattern(first, last)
+    {
+        auto size = m_pattern.size();
+        m_shift.fill(size);
+        m_backShift.fill(size);
+        for (size_t idx=0; idx + 1 < size; ++idx)
+        {
+            m_shift[static_cast<uint8_t>(m_pattern[idx])] = size - 1 - idx;
+        }
+        for (auto idx=size; idx-- > 1; )
+        {
+            m_backShift[static_cast<uint8_t>(m_pattern[idx])] = idx;
+        }
+    }
+
+    /**
+     * The first occurrence in [first, last), or last. With gaveUp, stops once the candidates it has checked add up to
+     * more than VerifySlack bytes beyond the distance scanned, and sets *gaveUp to where it stopped.
+     */
+    char const* Find(char const* first, char const* last, char const** gaveUp = nullptr) const
+    {
+        size_t size = m_pattern.size();
+        size_t textSize = last - first;
+        if (size == 0 || textSize < size)
+        {
+            return size == 0 ? first : last;
+        }
+        auto text = reinterpret_cast<uint8_t const*>(first);
+        auto lastByte = static_cast<uint8_t>(m_pattern.back());
+        size_t verified{0};
+        for (size_t pos=0; pos <= textSize - size; )
+        {
+            auto byte = text[pos + size - 1];
+            if (byte == lastByte)
+            {
+                if (std::memcmp(first + pos, m_pattern.data(), size - 1) == 0)
+                {
+                    return first + pos;
+                }
+                verified += size;
+                if (gaveUp && verified > pos + VerifySlack)
+                {
+                    *gaveUp = first + pos;
+                    return last;
+                }
+            }
+            pos += m_shift[byte];
+        }
+        return last;
+    }
+
+    /**
+     * The last occurrence in [first, last), or last
+     */
+    char const* FindLast(char const* first, char const* last) const
+    {
+        size_t size = m_pattern.size();
+        size_t textSize = last - first;
+        if (size == 0 || textSize < size)
+        {
+            return last;
+        }
+        auto text = reinterpret_cast<uint8_t const*>(first);
+        auto firstByte = static_cast<uint8_t>(m_pattern.front());
+        for (auto pos=textSize - size; ; )
+        {
+            auto byte = text[pos];
+            if (byte == firstByte && std::memcmp(first + pos + 1, m_pattern.data() + 1, size - 1) == 0)
+            {
+                return first + pos;
+            }
+            auto shift = m_backShift[byte];
+            if (shift > pos)
+            {
+                return last;
+            }
+            pos -= shift;
+        }
+    }
+
+private:
+    std::string m_pattern;
+    std::array<size_t, 256> m_shift; //window end to the last copy of the byte, not counting the final one
+    std::array<size_t, 256> m_backShift; //window start to the first copy of the byte, not counting the first one
+};
+
+/**
+ * Crochemore-Perrin two-way search: linear time and constant space whatever the text and pattern. The pattern is
+ * split at a critical factorization (the later of the two maximal suffixes, for the two byte orders), the right
+ * half is matched left to right and then the left half right to left. A mismatch on the right shifts past it;
+ * after a match or a mismatch on the left the shift is the period, and for a periodic pattern the prefix that is
+ * known to match again is remembered so no byte is compared twice.
+ */
+class TwoWay
+{
+public:
+    TwoWay() = delete;
+    TwoWay(char const* first, char const* last) : m_pattern(first, last)
+    {
+        auto size = m_pattern.size();
+        if (size == 0)
+        {
+            return;
+        }
+        auto forward = MaxSuffix(false);
+        auto backward = MaxSuffix(true);
+        std::tie(m_split, m_period) = forward.first > backward.first ? forward : backward;
+        m_periodic = m_split + m_period <= size && std::memcmp(m_pattern.data(), m_pattern.data() + m_period, m_split) == 0;
+        if (!m_periodic)
+        {
+            m_period = std::max(m_split, size - m_split) + 1;
+        }
+    }
+
+    /**
+     * The first occurrence in [first, last), or last
+     */
+    char const* Find(char const* first, char const* last) const
+    {
+        size_t size = m_pattern.size();
+        size_t textSize = last - first;
+        if (size == 0 || textSize < size)
+        {
+            return size == 0 ? first : last;
+        }
+        auto text = reinterpret_cast<uint8_t const*>(first);
+        auto pattern = reinterpret_cast<uint8_t const*>(m_pattern.data());
+        size_t memory{0}; //bytes at the start of the window known to match, periodic patterns only
+        for (size_t pos=0; pos <= textSize - size; )
+        {
+            auto idx = std::max(m_split, memory);
+            while (idx < size && pattern[idx] == text[pos + idx])
+            {
+                ++idx;
+            }
+            if (idx < size)
+            {
+                pos += idx - m_split + 1;
+                memory = 0;
+                continue;
+            }
+            idx = m_split;
+            while (idx > memory && pattern[idx - 1] == text[pos + idx - 1])
+            {
+                --idx;
+            }
+            if (idx <= memory)
+            {
+                return first + pos;
+            }
+            pos += m_period;
+            memory = m_periodic ? size - m_period : 0;
+        }
+        return last;
+    }
+
+private:
+    /**
+     * Where the lexicographically greatest suffix starts (under the reversed byte order if reversed), and its period
+     */
+    std::pair<size_t, size_t> MaxSuffix(bool reversed) const
+    {
+        auto pattern = reinterpret_cast<uint8_t const*>(m_pattern.data());
+        size_t size = m_pattern.size();
+        size_t start{0};
+        size_t candidate{1};
+        size_t offset{0};
+        size_t period{1};
+        while (candidate + offset < size)
+        {
+            auto lhs = pattern[candidate + offset];
+            auto rhs = pattern[start + offset];
+            if (lhs == rhs)
+            {
+                if (++offset == period)
+                {
+                    candidate += period;
+                    offset = 0;
+                }
+            }
+            else if (reversed ? lhs < rhs : lhs > rhs)
+            {
+                start = candidate++;
+                offset = 0;
+                period = 1;
+            }
+            else
+            {
+                candidate += offset + 1;
+                offset = 0;
+                period = candidate - start;
+            }
+        }
+        return {start, period};
+    }
+
+    std::string m_pattern;
+    size_t m_split{0};
+    size_t m_period{1};
+    bool m_periodic{false};
+};
+
+/**
+ * One pattern, searched the fastest way that is safe:
+ *  - a single byte is a memchr
+ *  - with SSE4.2 or AVX2, the generic SIMD filter: compare the first and the last byte of the pattern against 16
+ *    or 32 window positions at once, and only memcmp the ones where both match
+ *  - otherwise Horspool
+ * The filter and Horspool are fast on real text but O(nm) on something like "aaa...ab" in "aaa...", so both count
+ * what their candidate checks cost, and once that runs more than Horspool::VerifySlack ahead of the scan, TwoWay
+ * finishes the search in linear time. FindLast is always the reverse Horspool.
+ */
+class Searcher
+{
+public:
+    Searcher() = delete;
+    explicit Searcher(std::string pattern, SimdLevel level = SimdSearch::Detected()) :
+        m_pattern{std::move(pattern)},
+        m_horspool{m_pattern.data(), m_pattern.data() + m_pattern.size()},
+        m_twoWay{m_pattern.data(), m_pattern.data() + m_pattern.size()},
+        m_level{std::min(level, SimdSearch::Detected())}
+    {
+    }
+
+    std::string const& Pattern() const {return m_pattern;}
+    size_t MaxLength() const {return m_pattern.size();}
+
+    /**
+     * The first occurrence in [first, last), or last (first for an empty pattern), like std::search
+     */
+    char const* Find(char const* first, char const* last) const
+    {
+        size_t size = m_pattern.size();
+        size_t textSize = last - first;
+        if (size == 0 || textSize < size)
+        {
+            return size == 0 ? first : last;
+        }
+        if (size == 1)
+        {
+            auto found = std::memchr(first, m_pattern[0], textSize);
+            return found ? static_cast<char const*>(found) : last;
+        }
+
+        auto text = reinterpret_cast<uint8_t const*>(first);
+        size_t stop{0};
+#if defined(__x86_64__) || defined(__i386__)
+        if (m_level != SimdLevel::Scalar)
+        {
+            auto found = m_level == SimdLevel::Avx2 ? FilterAvx2(text, textSize, stop) : FilterSse42(text, textSize, stop);
+            return found != textSize ? first + found : m_twoWay.Find(first + stop, last);
+        }
+#endif
+        char const* gaveUp{nullptr};
+        auto found = m_horspool.Find(first, last, &gaveUp);
+        return gaveUp ? m_twoWay.Find(gaveUp, last) : found;
+    }
+
+    /**
+     * The last occurrence in [first, last), or last (also for an empty pattern), like std::find_end
+     */
+    char const* FindLast(char const* first, char const* last) const
+    {
+        return m_horspool.FindLast(first, last);
+    }
+
+    /**
+     * match(0, offset) for every occurrence, overlapping ones included, in order. Nothing for an empty pattern.
+     */
+    template <typename Match>
+    void ForEachMatch(char const* first, char const* last, Match match) const
+    {
+        if (m_pattern.empty())
+        {
+            return;
+        }
+        for (auto pos=Find(first, last); pos != last; pos = Find(pos + 1, last))
+        {
+            match(size_t{0}, static_cast<size_t>(pos - first));
+        }
+    }
+
+private:
+#if defined(__x86_64__) || defined(__i386__)
+    /**
+     * The first match at or after 0 the filter finds, or size. Sets stop to where it stopped looking: the tail too
+     * short for a full vector, or where it gave up. The pattern is at least 2 bytes.
+     */
+    __attribute__((target("avx2")))
+    size_t FilterAvx2(uint8_t const* text, size_t size, size_t& stop) const
+    {
+        auto length = m_pattern.size();
+        auto pattern = m_pattern.data();
+        auto head = _mm256_set1_epi8(pattern[0]);
+        auto tail = _mm256_set1_epi8(pattern[length - 1]);
+        size_t verified{0};
+        size_t pos{0};
+        for (; pos + length - 1 + 32 <= size; pos += 32)
+        {
+            auto firsts = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(text + pos));
+            auto lasts = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(text + pos + length - 1));
+            auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(firsts, head),
+                                                                                     _mm256_cmpeq_epi8(lasts, tail))));
+            for (; mask != 0; mask &= mask - 1)
+            {
+                auto candidate = pos + __builtin_ctz(mask);
+                if (std::memcmp(text + candidate + 1, pattern + 1, length - 2) == 0)
+                {
+                    return candidate;
+                }
+                verified += length;
+            }
+            if (verified > pos + Horspool::VerifySlack)
+            {
+                break;
+            }
+        }
+        stop = pos;
+        return size;
+    }
+
+    __attribute__((target("sse4.2")))
+    size_t FilterSse42(uint8_t const* text, size_t size, size_t& stop) const
+    {
+        auto length = m_pattern.size();
+        auto pattern = m_pattern.data();
+        auto head = _mm_set1_epi8(pattern[0]);
+        auto tail = _mm_set1_epi8(pattern[length - 1]);
+        size_t verified{0};
+        size_t pos{0};
+        for (; pos + length - 1 + 16 <= size; pos += 16)
+        {
+            auto firsts = _mm_loadu_si128(reinterpret_cast<__m128i const*>(text + pos));
+            auto lasts = _mm_loadu_si128(reinterpret_cast<__m128i const*>(text + pos + length - 1));
+            auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(firsts, head), _mm_cmpeq_epi8(lasts, tail))));
+            for (; mask != 0; mask &= mask - 1)
+            {
+                auto candidate = pos + __builtin_ctz(mask);
+                if (std::memcmp(text + candidate + 1, pattern + 1, length - 2) == 0)
+                {
+                    return candidate;
+                }
+                verified += length;
+            }
+            if (verified > pos + Horspool::VerifySlack)
+            {
+                break;
+            }
+        }
+        stop = pos;
+        return size;
+    }
+#endif
+
+    std::string m_pattern;
+    Horspool m_horspool;
+    TwoWay m_twoWay;
+    SimdLevel m_level;
+};
+
+/**
+ * Aho-Corasick: every pattern at once in one pass over the text, a table lookup per byte. The trie of the patterns is
+ * turned into a full automaton (every missing transition filled in from the failure link), so there is no failure
+ * chasing while scanning. Bytes that appear in no pattern share one column, which keeps the table at
+ * states x (distinct pattern bytes + 1) entries (up to 2^31 of them). Empty patterns never match.
+ */
+class AhoCorasick
+{
+public:
+    AhoCorasick() = delete;
+    explicit AhoCorasick(std::vector<std::string> patterns) : m_patterns{std::move(patterns)}
+    {
+        for (auto const& pattern: m_patterns)
+        {
+            for (auto byte: pattern)
+            {
+                auto& column = m_column[static_cast<uint8_t>(byte)];
+                if (column == 0)
+                {
+                    column = m_columns++;
+                }
+            }
+        }
+
+        //the trie, missing transitions are Missing until the automaton is built
+        m_next.assign(m_columns, Missing);
+        std::vector<std::vector<uint32_t>> ends(1);
+        for (auto idx=0U; idx < m_patterns.size(); ++idx)
+        {
+            uint32_t state{0};
+            for (auto byte: m_patterns[idx])
+            {
+                auto& next = m_next[state * m_columns + m_column[static_cast<uint8_t>(byte)]];
+                if (next == Missing)
+                {
+                    next = static_cast<uint32_t>(ends.size());
+                    ends.emplace_back();
+                    m_next.resize(m_next.size() + m_columns, Missing);
+                }
+                state = m_next[state * m_columns + m_column[static_cast<uint8_t>(byte)]];
+            }
+            if (state != 0)
+            {
+                ends[state].push_back(idx);
+                m_longest = std::max(m_longest, m_patterns[idx].size());
+            }
+        }
+
+        //breadth first, so a state's failure link is complete before its children need it
+        auto states = ends.size();
+        std::vector<uint32_t> fail(states, 0);
+        std::vector<uint32_t> order{0};
+        for (size_t head=0; head < order.size(); ++head)
+        {
+            auto state = order[head];
+            for (auto column=0U; column < m_columns; ++column)
+            {
+                auto& next = m_next[state * m_columns + column];
+                auto fallback = state == 0 ? 0 : m_next[fail[state] * m_columns + column];
+                if (next == Missing)
+                {
+                    next = fallback;
+                }
+                else
+                {
+                    fail[next] = fallback;
+                    order.push_back(next);
+                }
+            }
+        }
+
+        //m_dict: the nearest state down the failure chain where a pattern ends, m_report: the same, or the state itself
+        m_dict.assign(states, 0);
+        m_report.assign(states, 0);
+        m_endStart.assign(states + 1, 0);
+        for (auto state: order)
+        {
+            auto failState = fail[state];
+            m_dict[state] = (state == 0) ? 0 : (ends[failState].empty() ? m_dict[failState] : failState);
+            m_report[state] = ends[state].empty() ? m_dict[state] : state;
+        }
+        for (auto state=0U; state < states; ++state)
+        {
+            m_endStart[state + 1] = m_endStart[state] + static_cast<uint32_t>(ends[state].size());
+            m_ends.insert(m_ends.end(), ends[state].begin(), ends[state].end());
+        }
+
+        //the scan follows row offsets, not state numbers, so it never multiplies
+        for (auto& next: m_next)
+        {
+            next = (next * m_columns) << 1 | (m_report[next] != 0 ? 1 : 0);
+        }
+    }
+
+    size_t Patterns() const {return m_patterns.size();}
+    std::string const& Pattern(size_t idx) const {return m_patterns[idx];}
+    size_t MaxLength() const {return m_longest;}
+
+    /**
+     * match(pattern, offset) for every occurrence of every pattern, in the order they end (for patterns ending at
+     * the same byte, longest first)
+     */
+    template <typename Match>
+    void ForEachMatch(char const* first, char const* last, Match match) const
+    {
+        auto text = reinterpret_cast<uint8_t const*>(first);
+        size_t size = last - first;
+        uint32_t next{0};
+        for (size_t idx=0; idx < size; ++idx)
+        {
+            next = m_next[(next >> 1) + m_column[text[idx]]];
+            if ((next & 1) == 0)
+            {
+                continue;
+            }
+            for (auto report=m_report[(next >> 1) / m_columns]; report != 0; report = m_dict[report])
+            {
+                for (auto end=m_endStart[report]; end < m_endStart[report + 1]; ++end)
+                {
+                    auto pattern = m_ends[end];
+                    match(size_t{pattern}, idx + 1 - m_patterns[pattern].size());
+                }
+            }
+        }
+    }
+
+private:
+    static constexpr uint32_t Missing{UINT32_MAX};
+
+    std::vector<std::string> m_patterns;
+    std::array<uint32_t, 256> m_column{}; //0 for bytes in no pattern
+    uint32_t m_columns{1};
+    std::vector<uint32_t> m_next; //for [state * m_columns + column], the next state's row offset << 1 | whether it reports
+    std::vector<uint32_t> m_dict;
+    std::vector<uint32_t> m_report;
+    std::vector<uint32_t> m_endStart; //the patterns ending at state are m_ends[m_endStart[state], m_endStart[state + 1])
+    std::vector<uint32_t> m_ends;
+    size_t m_longest{0};
+};
+
+/**
+ * A file mapped read-only, for searching without reading it into memory first. Move only, unmapped on destruction.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(MappedFile const&) = delete;
+    MappedFile(MappedFile&& other) noexcept {*this = std::move(other);}
+    MappedFile& operator=(MappedFile&& other) noexcept
+    {
+        std::swap(m_map, other.m_map);
+        std::swap(m_size, other.m_size);
+        return *this;
+    }
+    ~MappedFile()
+    {
+        if (m_map)
+        {
+            munmap(m_map, m_size);
+        }
+    }
+
+    /**
+     * Map the file at path, throws std::runtime_error if it can't be opened or mapped. An empty file maps nothing.
+     */
+    static MappedFile Open(std::string const& path)
+    {
+        auto fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Unable to open " + path + ": " + std::strerror(errno));
+        }
+        struct stat info{};
+        fstat(fd, &info);
+
+        MappedFile file;
+        if (info.st_size > 0)
+        {
+            file.m_map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (file.m_map == MAP_FAILED)
+            {
+                file.m_map = nullptr;
+            }
+        }
+        ::close(fd);
+        if (info.st_size > 0 && !file.m_map)
+        {
+            throw std::runtime_error("Unable to map " + path);
+        }
+        file.m_size = info.st_size;
+        if (file.m_map)
+        {
+            madvise(file.m_map, file.m_size, MADV_SEQUENTIAL);
+        }
+        return file;
+    }
+
+    char const* Begin() const {return static_cast<char const*>(m_map);}
+    char const* End() const {return Begin() + m_size;}
+    size_t Size() const {return m_size;}
+
+private:
+    void* m_map{nullptr};
+    size_t m_size{0};
+};
+
+struct TextMatch
+{
+    size_t m_offset;
+    size_t m_pattern; //always 0 for a Searcher, the index into the patterns for AhoCorasick
+
+    bool operator<(TextMatch const& rhs) const {return std::tie(m_offset, m_pattern) < std::tie(rhs.m_offset, rhs.m_pattern);}
+    bool operator==(TextMatch const& rhs) const {return m_offset == rhs.m_offset && m_pattern == rhs.m_pattern;}
+};
+
+class TextSearch
+{
+public:
+    /**
+     * Every match of a Searcher or an AhoCorasick in [first, last), sorted by offset and then pattern, found a block
+     * per task. Each block also scans the first MaxLength() - 1 bytes of the next one, and keeps only the matches
+     * that start inside it, so a match across a block boundary is found once, by the block it starts in.
+     */
+    template <typename Pool, typename Engine>
+    static std::vector<TextMatch> FindAll(ParallelPolicy<Pool> const& policy, char const* first, char const* last, Engine const& engine)
+    {
+        size_t size = last - first;
+        if (engine.MaxLength() == 0)
+        {
+            return {};
+        }
+        auto overlap = engine.MaxLength() - 1;
+        std::vector<std::vector<TextMatch>> found(policy.Blocks(size));
+        policy.ForEachBlock(size, [&](size_t block, size_t lo, size_t hi) {
+            auto& matches = found[block];
+            engine.ForEachMatch(first + lo, first + std::min(hi + overlap, size), [&](size_t pattern, size_t offset) {
+                if (lo + offset < hi)
+                {
+                    matches.push_back({lo + offset, pattern});
+                }
+            });
+            std::sort(matches.begin(), matches.end());
+        });
+
+        std::vector<TextMatch> matches;
+        for (auto const& cur: found)
+        {
+            matches.insert(matches.end(), cur.begin(), cur.end());
+        }
+        return matches;
+    }
+};
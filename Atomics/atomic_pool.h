@@ -0,0 +1,381 @@
+#pragma once
+
+#include <thread>
+#include <functional>
+#include <atomic>
+#include <list>
+#include <iostream>
+#include <sstream>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+
+#include "cpu_relax.h"
+#include "mpmc_queue.h"
+#include "event_count.h"
+#include "locks.h"
+#include "locked_queue.h"
+#include "../Threading/task.h"
+#include "../Threading/pool_stats.h"
+#include "../Threading/topology.h"
+
+/**
+ * A thread pool built on atomics only. Work is handed out through a lock-free bounded MPMC ring buffer, and
+ * idle workers sleep on an eventcount (futex backed) rather than spinning, so an idle pool costs no CPU.
+ * AddWork blocks while the queue is full, which gives back-pressure to a producer that outruns the pool.
+ * Stats() returns per worker telemetry (see pool_stats.h) at any time. A PlacementPolicy (see topology.h) pins the
+ * workers to CPUs.
+ *
+ * Lock picks the queue: LockFree (the default) for the MPMC ring, or any lock from locks.h to guard a plain ring
+ * with, for comparison.
+ */
+template <typename Lock = LockFree>
+class ThreadPool
+{
+public:
+    using WorkFunction = Task;
+
+    ThreadPool(size_t maxThreads, size_t queueCapacity = 65536, PlacementPolicy placement = {})
+        : m_maxThreads{maxThreads}
+        , m_workList{queueCapacity}
+        , m_placement{PlaceWorkers(placement, maxThreads)}
+    {
+        for (auto count=0U; count < m_maxThreads; ++count)
+        {
+            m_counters.push_back(std::make_unique<WorkerCounters>());
+        }
+    }
+    ThreadPool() = delete;
+    ThreadPool(ThreadPool const&) = delete;
+
+    size_t Threads() const {return m_maxThreads;}
+
+    /**
+     * Queue any void() callable. It is moved into the ring buffer slot, and stored inline when it is small.
+     */
+    template <typename F>
+    void AddWork(F&& func)
+    {
+        QueuedWork work{WorkFunction{std::forward<F>(func)}, ReadTicks()};
+        while (!m_workList.TryPush(std::move(work)))
+        {
+            auto key = m_notFull.PrepareWait();
+            if (m_workList.TryPush(std::move(work)))
+            {
+                m_notFull.CancelWait();
+                break;
+            }
+            m_notFull.Wait(key);
+        }
+        UpdateMax(m_queueHighWater, m_workList.Size());
+        m_notEmpty.NotifyOne();
+    }
+
+    void Start()
+    {
+        WaitOnFlag wait(m_flag);
+        if (!m_threads.empty())
+        {
+            std::cout << "ThreadPool is already running" << std::endl;
+            return;
+        }
+
+        for (size_t count=0; count < m_maxThreads; ++count)
+        {
+            m_threads.push_front(std::thread(std::bind(&ThreadPool::Run, this, count)));
+        }
+    }
+
+    /**
+     * Finish all queued work, then join the workers
+     */
+    void Stop()
+    {
+        m_stopping.store(true);
+        m_notEmpty.NotifyAll();
+        for (auto& cur: m_threads)
+        {
+            cur.join();
+        }
+        std::cout << "Total work " << m_totalWork << std::endl;
+    }
+
+    /**
+     * A snapshot of the pool's telemetry. Cheap enough to poll while the pool is busy.
+     */
+    PoolStats Stats() const
+    {
+        auto nsPerTick = m_calibration.NsPerTick();
+        PoolStats stats;
+        for (auto& cur: m_counters)
+        {
+            stats.m_workers.emplace_back(*cur, nsPerTick);
+        }
+        stats.m_external = WorkerStats{m_externalCounters, nsPerTick};
+        stats.m_queueDepth = m_workList.Size();
+        stats.m_queueHighWater = m_queueHighWater;
+        return stats;
+    }
+
+    /**
+     * Submit the range [begin, end) as a handful of chunked tasks that call body(index) for every index, and return
+     * without waiting. grain is the smallest chunk a range is split down to, 0 sizes the chunks from the measured
+     * cost of body. A running chunk gives the upper half of what it has left back to the queue while workers are
+     * asleep for lack of work.
+     */
+    template <typename Body>
+    void AddBulk(size_t begin, size_t end, size_t grain, Body body)
+    {
+        if (begin >= end)
+        {
+            return;
+        }
+        SubmitBulk(std::make_shared<BulkState<Body>>(std::move(body), grain, end - begin), begin, end);
+    }
+
+    /**
+     * As AddBulk, but return once the whole range is done. The calling thread runs queued work while it waits.
+     */
+    template <typename Body>
+    void ParallelFor(size_t begin, size_t end, size_t grain, Body body)
+    {
+        if (begin >= end)
+        {
+            return;
+        }
+        auto state = std::make_shared<BulkState<Body>>(std::move(body), grain, end - begin);
+        SubmitBulk(state, begin, end);
+        size_t remaining;
+        while ((remaining = state->m_remaining.load()) != 0)
+        {
+            if (RunOne())
+            {
+                continue;
+            }
+            if (t_pool == this)
+            {
+                CpuRelax(); //never sleep on a worker, the rest of the range may be queued behind us
+                continue;
+            }
+            state->m_remaining.wait(remaining); //only woken when the count reaches 0
+        }
+    }
+
+    /**
+     * Run one piece of queued work on the calling thread. Returns false if the queue was empty.
+     */
+    bool RunOne()
+    {
+        QueuedWork cur;
+        if (!m_workList.TryPop(cur))
+        {
+            return false;
+        }
+        m_notFull.NotifyOne();
+        Record(cur, (t_pool == this) ? *t_workerCounters : m_externalCounters);
+        ++m_totalWork;
+        return true;
+    }
+
+private:
+    static constexpr int SpinCount{64}; //polls of an empty queue before a worker goes to sleep
+    static constexpr size_t InitialChunksPerThread{4}; //how many chunks AddBulk starts with per worker
+    static constexpr auto TargetStepTime = std::chrono::microseconds{20}; //automatic grain aims for this much work
+
+    using Clock = std::chrono::steady_clock;
+
+    template <typename Body>
+    struct BulkState
+    {
+        BulkState(Body body, size_t grain, size_t count) : m_body{std::move(body)}, m_grain{grain}, m_remaining{count}
+        {
+        }
+        Body m_body;
+        size_t m_grain; //0 for automatic
+        std::atomic<size_t> m_remaining; //indices that haven't been processed yet
+    };
+
+    template <typename Body>
+    void SubmitBulk(std::shared_ptr<BulkState<Body>> const& state, size_t begin, size_t end)
+    {
+        auto count = end - begin;
+        auto minChunk = std::max<size_t>(state->m_grain, 1);
+        auto chunks = std::min((count + minChunk - 1) / minChunk, std::max<size_t>(m_maxThreads, 1) * InitialChunksPerThread);
+        auto lo = begin;
+        for (auto chunk=0U; chunk < chunks; ++chunk)
+        {
+            auto hi = lo + count / chunks + (chunk < count % chunks ? 1 : 0);
+            AddWork([this, state, lo, hi]{RunChunk(state, lo, hi);});
+            lo = hi;
+        }
+    }
+
+    template <typename Body>
+    void RunChunk(std::shared_ptr<BulkState<Body>> const& state, size_t lo, size_t hi)
+    {
+        auto step = std::max<size_t>(state->m_grain, 1);
+        size_t done{0};
+        while (lo < hi)
+        {
+            if (hi - lo >= 2 * step && m_notEmpty.HasWaiters())
+            {
+                //never block a worker on a full queue, if there is no room the chunk just stays whole
+                auto mid = lo + (hi - lo) / 2;
+                QueuedWork half{WorkFunction{[this, state, mid, hi]{RunChunk(state, mid, hi);}}, ReadTicks()};
+                if (m_workList.TryPush(std::move(half)))
+                {
+                    m_notEmpty.NotifyOne();
+                    hi = mid;
+                }
+            }
+
+            auto stop = std::min(hi, lo + step);
+            done += stop - lo;
+            if (state->m_grain != 0)
+            {
+                for (; lo < stop; ++lo)
+                {
+                    state->m_body(lo);
+                }
+                continue;
+            }
+
+            //automatic grain, grow or shrink the step so each one takes about TargetStepTime
+            auto start = Clock::now();
+            for (; lo < stop; ++lo)
+            {
+                state->m_body(lo);
+            }
+            auto elapsed = Clock::now() - start;
+            if (elapsed < TargetStepTime / 2)
+            {
+                step *= 2;
+            }
+            else if (elapsed > TargetStepTime * 2 && step > 1)
+            {
+                step /= 2;
+            }
+        }
+
+        if (state->m_remaining.fetch_sub(done) == done)
+        {
+            state->m_remaining.notify_all();
+        }
+    }
+
+    /**
+     * A queued WorkFunction and when it was queued
+     */
+    struct QueuedWork
+    {
+        WorkFunction m_work;
+        uint64_t m_enqueued{0}; //ReadTicks() at AddWork
+    };
+
+    /**
+     * Run cur, recording its queue wait and run time
+     */
+    static void Record(QueuedWork& cur, WorkerCounters& counters)
+    {
+        auto start = ReadTicks();
+        counters.m_wait[LaneOf(Priority::Normal)].Record(start - cur.m_enqueued);
+        cur.m_work();
+        counters.m_run.Record(ReadTicks() - start);
+        counters.m_tasks.Add(1);
+    }
+
+    void Run(size_t index) //worker function
+    {
+        if (!PinCurrentThread(m_placement[index].m_cpus))
+        {
+            std::ostringstream msg;
+            msg << "Unable to pin worker " << index << ", it will run unpinned" << std::endl;
+            std::cout << msg.str();
+        }
+        t_pool = this;
+        t_workerCounters = m_counters[index].get();
+        size_t threadWork{0};
+        ++m_totalThreads;
+        ++m_availableThreads;
+
+        while (true)
+        {
+            QueuedWork cur;
+            if (!Take(cur))
+            {
+                break;
+            }
+            m_notFull.NotifyOne();
+
+            --m_availableThreads;
+            Record(cur, *t_workerCounters);
+            ++m_availableThreads;
+            ++threadWork;
+            ++m_totalWork;
+        }
+        --m_totalThreads;
+        --m_availableThreads;
+
+        std::ostringstream msg;
+        msg << "Thread Exiting, total work for this thread is " << threadWork << std::endl;
+        std::cout << msg.str();
+    }
+
+    /**
+     * Get the next piece of work, sleeping while there is none. Returns false once stopped and drained.
+     */
+    bool Take(QueuedWork& cur)
+    {
+        auto idleStart = ReadTicks();
+        auto idle = [&]{t_workerCounters->m_idleTicks.Add(ReadTicks() - idleStart);};
+        while (true)
+        {
+            for (auto spin=0; spin < SpinCount; ++spin)
+            {
+                if (m_workList.TryPop(cur))
+                {
+                    idle();
+                    return true;
+                }
+                CpuRelax();
+            }
+
+            auto key = m_notEmpty.PrepareWait();
+            if (m_workList.TryPop(cur))
+            {
+                m_notEmpty.CancelWait();
+                idle();
+                return true;
+            }
+            if (m_stopping.load())
+            {
+                //Stop is only called once all AddWork calls have returned, so empty now means empty for good
+                m_notEmpty.CancelWait();
+                return false;
+            }
+            m_notEmpty.Wait(key);
+        }
+    }
+
+private:
+    size_t m_maxThreads; //how many threads to create
+    std::list<std::thread> m_threads; //active threads
+    PoolQueue<QueuedWork, Lock> m_workList; //a queue of work to distribute to your threads
+    EventCount m_notEmpty; //idle workers sleep here
+    EventCount m_notFull; //producers sleep here while the queue is full
+    std::atomic<bool> m_stopping{false}; //set by Stop, workers exit once the queue is drained
+
+    std::atomic<size_t> m_availableThreads{0}; //how many threads are waiting for work
+    std::atomic<size_t> m_totalThreads{0}; //number of threads that are alive
+    std::atomic<size_t> m_totalWork{0}; //Number of WorkFunctions executed across all threads in the pool
+    std::atomic_flag m_flag{ATOMIC_FLAG_INIT}; //used for synchronization
+
+    std::vector<WorkerPlacement> m_placement; //CPUs for each worker
+    std::vector<std::unique_ptr<WorkerCounters>> m_counters; //telemetry, one per worker
+    WorkerCounters m_externalCounters; //pool work run by threads that aren't workers
+    std::atomic<size_t> m_queueHighWater{0};
+    TickCalibration m_calibration;
+
+    inline static thread_local ThreadPool* t_pool{nullptr}; //the pool the calling thread works for, if any
+};
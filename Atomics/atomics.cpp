@@ -9,217 +9,144 @@
 #include <sstream>
 #include <string>
 #include <iomanip>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <vector>
 
-/**
- * An RAII style class implementing a spin-lock using std::atomic_flag
- */
-class WaitOnFlag
-{
-    public:
-        WaitOnFlag()=delete;
-        WaitOnFlag(WaitOnFlag const&) = delete;
-        WaitOnFlag(std::atomic_flag& flag) : m_flag(flag) 
-        {
-            while (m_flag.test_and_set()) {} //block till we win
-        }
-        ~WaitOnFlag()
-        {
-            m_flag.clear();
-        }
-    private:
-        std::atomic_flag& m_flag;
-};
-
-class ThreadPool
-{
-public:
-    using WorkFunction = std::function<void()>;
-
-    ThreadPool(size_t maxThreads) : m_maxThreads{maxThreads}
-    {
-    }
-    ThreadPool() = delete;
-    ThreadPool(ThreadPool const&) = delete;
-
-    void AddWork(WorkFunction work)
-    {
-        WaitOnFlag wait(m_flag);
-        m_workList.push_back(work);
-    }
-
-    void Start()
-    {
-        WaitOnFlag wait(m_flag);
-        if (!m_threads.empty())
-        {
-            std::cout << "ThreadPool is already running" << std::endl;
-            return;
-        }
-
-        for (auto count=0; count < m_maxThreads; ++count)
-        {
-            m_threads.push_front(std::thread(std::bind(&ThreadPool::Run, this)));
-        }
-    }
-
-    void Stop()
-    {
-        AddWork(nullptr);
-        for (auto& cur: m_threads)
-        {
-            cur.join();
-        }
-        std::cout << "Total work " << m_totalWork << std::endl;
-    }
-
-private:
-    void Run() //worker function
-    {
-        size_t threadWork{0};
-        ++m_totalThreads;
-        ++m_availableThreads;
-
-        bool cont{true};
-        while (cont)
-        {
-            WorkFunction cur;
-
-            { //critical section
-                WaitOnFlag wait(m_flag);
-                if (m_workList.empty())
-                {
-                    continue;
-                }
-
-                cur = m_workList.front();
-                if (cur == nullptr)
-                {
-                    cont = false;
-                    continue;
-                }
-                m_workList.pop_front();
-            }
-
-            --m_availableThreads;
-            cur();
-            ++m_availableThreads;
-            ++threadWork;
-            ++m_totalWork;
-        }
-        --m_totalThreads;
-        --m_availableThreads;
-
-        std::ostringstream msg;
-        msg << "Thread Exiting, total work for this thread is " << threadWork << std::endl;
-        std::cout << msg.str();
-    }
-
-private:
-    size_t m_maxThreads; //how many threads to create
-    std::list<std::thread> m_threads; //active threads
-    std::list<WorkFunction> m_workList; //a queue of work to distribute to your threads
-
-    std::atomic<size_t> m_availableThreads{0}; //how many threads are waiting for work
-    std::atomic<size_t> m_totalThreads{0}; //number of threads that are alive
-    std::atomic<size_t> m_totalWork{0}; //Number of WorkFunctions executed across all threads in the pool
-    std::atomic_flag m_flag{ATOMIC_FLAG_INIT}; //used for synchronization
-};
-
+#include "atomic_pool.h"
+#include "../Threading/primality.h"
 
 /**
- * A class for testing and storing prime numbers. The algorithm is simple, and was stolen from Google.
- * It is not important to the example, it is just a computationally intensive function (well, for larger numbers)
+ * A class for testing and storing prime numbers. The test is Primality::IsPrime: trial division by the primes below
+ * 60, then a deterministic Miller-Rabin test in Montgomery arithmetic. It is not important to the example, it is
+ * just a computationally intensive function (well, for larger numbers)
  *
+ * Found primes are marked in a bitmap indexed by value with an atomic fetch_or, so recording one is a single
+ * uncontended atomic (threads only share a word where their ranges meet), and reading them back in order is a scan.
  */
 class FactorPrimes
 {
 public:
+    FactorPrimes() = delete;
+    FactorPrimes(FactorPrimes const&) = delete;
+
     /**
-     * Only default constructable (no copy ctor)
+     * Room for the primes up to maxValue
      */
-    FactorPrimes() = default;
-    FactorPrimes(FactorPrimes const&) = delete;
+    explicit FactorPrimes(uint64_t maxValue) : m_maxValue{maxValue}, m_found(maxValue / 64 + 1)
+    {
+    }
 
     /**
-     * Check if the argument is prime, if it is, store it in the list. 
-     * Only takes the flag if a prime is found
+     * Check if the argument is prime, if it is, mark it in the bitmap
      */
-    void CheckPrime(uint32_t val)
+    void CheckPrime(uint64_t val)
     {
         //check if prime
-        if (IsPrime(val))
+        if (val <= m_maxValue && IsPrime(val))
         {
-            //if prime, add it to the list
-            WaitOnFlag wait(m_flag);
-            m_primes.push_back(val);
+            //if prime, set its bit
+            m_found[val / 64].fetch_or(1ULL << (val % 64), std::memory_order_relaxed);
         }
     }
 
     /**
-     * Returns true if a number is prime
+     * Returns true if a number is prime (see primality.h)
      */
-    bool IsPrime(uint32_t val)
+    bool IsPrime(uint64_t val)
     {
-        if (val == 0 || val == 1)
-        {
-            return false;
-        }
+        return Primality::IsPrime(val);
+    }
 
-        for (auto count=2; count <= val/2; ++count)
+    /**
+     * Get the primes we have found, in order. Call it once the checking is done (anything still running may or may
+     * not be included).
+     */
+    std::vector<uint64_t> GetPrimes() const
+    {
+        std::vector<uint64_t> primes;
+        primes.reserve(Count());
+        for (auto word=0U; word < m_found.size(); ++word)
         {
-            if (val % count == 0)
+            for (auto bits = m_found[word].load(std::memory_order_relaxed); bits != 0; bits &= bits - 1)
             {
-                return false;
+                primes.push_back(64ULL * word + __builtin_ctzll(bits));
             }
         }
-        return true;
+        return primes;
     }
 
     /**
-     * Get the current list of primes we have found
+     * How many primes we have found
      */
-    std::list<uint32_t> GetPrimes() const 
+    size_t Count() const
     {
-        WaitOnFlag wait(m_flag);
-        return m_primes;
+        size_t count{0};
+        for (auto& word: m_found)
+        {
+            count += __builtin_popcountll(word.load(std::memory_order_relaxed));
+        }
+        return count;
     }
 private:
-    mutable std::atomic_flag m_flag{ATOMIC_FLAG_INIT}; //use this for synchronization
-    std::list<uint32_t> m_primes; //if IsPrime is called with a number that is prime, that number will be stored here
+    uint64_t m_maxValue;
+    std::vector<std::atomic<uint64_t>> m_found; //bit v is set once v is known to be prime
 };
 
 /**
- * A simple main which takes 2 arguments (exactly), the first is the number of threads, the second is the upper limit
- * for calculating primes.
+ * Count the primes up to maxValue with poolSize threads, using Lock for the pool's queue
  */
-int main(int argc, char* argv[])
+template <typename Lock>
+void FindPrimes(size_t poolSize, size_t maxValue)
 {
-    if (argc != 3)
-    {
-        return -1;
-    }
-
-    size_t poolSize = std::stol(argv[1]);
-    size_t maxValue = std::stol(argv[2]);
-
-    ThreadPool pool{poolSize};
+    ThreadPool<Lock> pool{poolSize};
 
     pool.Start();
 
-    FactorPrimes factor;
+    FactorPrimes factor{maxValue};
 
-    for (auto count=1; count <= maxValue; ++count)
-    {
-        pool.AddWork(std::bind(&FactorPrimes::CheckPrime, &factor, count));
-    }
+    pool.ParallelFor(1, maxValue+1, 0, [&](size_t value){factor.CheckPrime(value);});
 
     pool.Stop();
+    std::cout << pool.Stats();
     /* output is disabled so we can look at computational time un-affected by string output
      * std::cout << "Prime numbers from 0 - " << maxValue << std::endl;
     for (auto& val: factor.GetPrimes())
     {
         std::cout << "|" << std::setw(16) << val << " | " << std::endl;
     }*/
-    std::cout << factor.GetPrimes().size() << " primes found from 0 - " << maxValue << std::endl;
+    std::cout << factor.Count() << " primes found from 0 - " << maxValue << std::endl;
+}
+
+/**
+ * A simple main which takes 2 arguments, the first is the number of threads, the second is the upper limit
+ * for calculating primes. An optional third picks the pool's queue: lockfree (the default), or a ring guarded by
+ * flag, ttas, ticket, mcs, clh, hybrid or mutex.
+ */
+int main(int argc, char* argv[])
+{
+    if (argc != 3 && argc != 4)
+    {
+        return -1;
+    }
+
+    size_t poolSize = std::stol(argv[1]);
+    size_t maxValue = std::stol(argv[2]);
+    std::string lock{argc == 4 ? argv[3] : "lockfree"};
+
+    if (lock == "lockfree") FindPrimes<LockFree>(poolSize, maxValue);
+    else if (lock == "flag") FindPrimes<WaitOnFlag>(poolSize, maxValue);
+    else if (lock == "ttas") FindPrimes<TtasLock>(poolSize, maxValue);
+    else if (lock == "ticket") FindPrimes<TicketLock>(poolSize, maxValue);
+    else if (lock == "mcs") FindPrimes<McsLock>(poolSize, maxValue);
+    else if (lock == "clh") FindPrimes<ClhLock>(poolSize, maxValue);
+    else if (lock == "hybrid") FindPrimes<HybridLock>(poolSize, maxValue);
+    else if (lock == "mutex") FindPrimes<StdMutexLock>(poolSize, maxValue);
+    else
+    {
+        std::cout << "Unknown lock " << lock << std::endl;
+        return -1;
+    }
     return 0;
 }
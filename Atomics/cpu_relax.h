@@ -0,0 +1,18 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Tell the CPU we are in a spin-wait loop. On x86 this is the pause instruction, which stops the spinning core
+ * from flooding the memory system with speculative loads and gives the other hyper-thread the pipeline.
+ */
+inline void CpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
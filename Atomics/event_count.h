@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * An eventcount: lets a thread sleep until a condition it polls (e.g. "queue not empty") may have changed,
+ * without a mutex and without the lost wakeup race.
+ *
+ * Waiter:
+ *     auto key = ec.PrepareWait();
+ *     if (condition()) { ec.CancelWait(); ... } else { ec.Wait(key); }
+ * Notifier:
+ *     make condition() true; ec.NotifyOne();
+ *
+ * Both sides issue a full fence between their write (waiter count / condition) and their read (condition /
+ * waiter count), so either the waiter sees the condition or the notifier sees the waiter. Sleeping is done
+ * with std::atomic::wait on the epoch, which is a futex on Linux, and notifiers with nobody waiting only pay
+ * for the fence and a load.
+ */
+class EventCount
+{
+public:
+    using Key = uint32_t;
+
+    EventCount() = default;
+    EventCount(EventCount const&) = delete;
+
+    Key PrepareWait()
+    {
+        m_waiters.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return m_epoch.load(std::memory_order_acquire);
+    }
+
+    void CancelWait()
+    {
+        m_waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Block until a notification newer than key
+     */
+    void Wait(Key key)
+    {
+        m_epoch.wait(key, std::memory_order_acquire);
+        m_waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void NotifyOne()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_waiters.load(std::memory_order_relaxed) != 0)
+        {
+            m_epoch.fetch_add(1, std::memory_order_release);
+            m_epoch.notify_one();
+        }
+    }
+
+    void NotifyAll()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_waiters.load(std::memory_order_relaxed) != 0)
+        {
+            m_epoch.fetch_add(1, std::memory_order_release);
+            m_epoch.notify_all();
+        }
+    }
+
+    /**
+     * True if somebody is (about to be) asleep. Only a hint, it can change as soon as it is read.
+     */
+    bool HasWaiters() const
+    {
+        return m_waiters.load(std::memory_order_relaxed) != 0;
+    }
+
+private:
+    alignas(64) std::atomic<Key> m_epoch{0}; //bumped on every notification that had someone to wake
+    alignas(64) std::atomic<uint32_t> m_waiters{0}; //threads between PrepareWait and Wait/CancelWait
+};
@@ -0,0 +1,93 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <string>
+
+#include "locks.h"
+#include "../Threading/bench.h"
+
+/**
+ * Contention microbenchmark for the locks in locks.h: threads hammer one lock, each critical section bumping a
+ * shared counter, timed through bench.h. The counter is checked afterwards so a broken lock can't post a good number.
+ */
+
+/**
+ * threads each take the lock opsPerThread times, returns false if an update was lost
+ */
+template <typename Lock>
+bool Hammer(size_t threads, size_t opsPerThread)
+{
+    typename Lock::Mutex mutex;
+    uint64_t counter{0};
+    std::atomic<size_t> ready{0};
+    std::atomic<bool> go{false};
+
+    std::vector<std::thread> workers;
+    for (auto idx=0U; idx < threads; ++idx)
+    {
+        workers.emplace_back([&]{
+            ++ready;
+            while (!go.load(std::memory_order_acquire))
+            {
+                CpuRelax();
+            }
+            for (auto op=0U; op < opsPerThread; ++op)
+            {
+                Lock wait(mutex);
+                ++counter;
+            }
+        });
+    }
+    while (ready != threads)
+    {
+        std::this_thread::yield();
+    }
+
+    go.store(true, std::memory_order_release);
+    for (auto& cur: workers)
+    {
+        cur.join();
+    }
+    return counter == threads * opsPerThread;
+}
+
+template <typename Lock>
+void Row(BenchSuite& suite, std::string const& name, std::vector<size_t> const& threadCounts, size_t opsPerThread)
+{
+    for (auto threads: threadCounts)
+    {
+        bool correct{true};
+        auto caseName = "lock/" + name + "/threads" + std::to_string(threads);
+        suite.Run(caseName, [&]{correct = Hammer<Lock>(threads, opsPerThread) && correct;}, threads * opsPerThread);
+        suite.Check(correct, caseName + " lost updates");
+    }
+}
+
+/**
+ * Takes the highest thread count (default: the hardware concurrency) and the operations per thread, and the options
+ * in bench.h, and runs every lock at 1, 2, 4, ... threads. Each item is one lock/unlock pair (thread start up is
+ * included in the time).
+ */
+int main(int argc, char* argv[])
+{
+    BenchSuite suite{"locks", argc, argv};
+    size_t maxThreads = suite.Arg(0, std::max(1U, std::thread::hardware_concurrency()));
+    size_t opsPerThread = suite.Arg(1, 200000);
+
+    std::vector<size_t> threadCounts;
+    for (size_t threads=1; threads < maxThreads; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    Row<StdMutexLock>(suite, "mutex", threadCounts, opsPerThread);
+    Row<WaitOnFlag>(suite, "flag", threadCounts, opsPerThread);
+    Row<TtasLock>(suite, "ttas", threadCounts, opsPerThread);
+    Row<TicketLock>(suite, "ticket", threadCounts, opsPerThread);
+    Row<McsLock>(suite, "mcs", threadCounts, opsPerThread);
+    Row<ClhLock>(suite, "clh", threadCounts, opsPerThread);
+    Row<HybridLock>(suite, "hybrid", threadCounts, opsPerThread);
+    return suite.Finish();
+}
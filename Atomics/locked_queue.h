@@ -0,0 +1,82 @@
+#pragma once
+
+#include <memory>
+#include <cstddef>
+#include <type_traits>
+
+#include "mpmc_queue.h"
+
+/**
+ * Tag for ThreadPool's Lock parameter: use the lock-free MpmcQueue rather than a locked one
+ */
+struct LockFree {};
+
+/**
+ * A bounded ring buffer guarded by one of the locks in locks.h, with the same interface as MpmcQueue, so the
+ * two can be swapped to compare a lock against the lock-free queue
+ */
+template <typename T, typename Lock>
+class LockedQueue
+{
+public:
+    LockedQueue() = delete;
+    LockedQueue(LockedQueue const&) = delete;
+
+    /**
+     * capacity is rounded up to a power of two
+     */
+    explicit LockedQueue(size_t capacity)
+    {
+        size_t size{2};
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        m_mask = size - 1;
+        m_slots = std::make_unique<T[]>(size);
+    }
+
+    bool TryPush(T&& value)
+    {
+        Lock wait(m_lock);
+        if (m_tail - m_head > m_mask)
+        {
+            return false;
+        }
+        m_slots[m_tail++ & m_mask] = std::move(value);
+        return true;
+    }
+
+    bool TryPop(T& out)
+    {
+        Lock wait(m_lock);
+        if (m_head == m_tail)
+        {
+            return false;
+        }
+        out = std::move(m_slots[m_head & m_mask]);
+        m_slots[m_head++ & m_mask] = T{};
+        return true;
+    }
+
+    size_t Size() const
+    {
+        Lock wait(m_lock);
+        return m_tail - m_head;
+    }
+
+    size_t Capacity() const {return m_mask + 1;}
+
+private:
+    mutable typename Lock::Mutex m_lock;
+    std::unique_ptr<T[]> m_slots;
+    size_t m_mask;
+    size_t m_head{0};
+    size_t m_tail{0};
+};
+
+/**
+ * The queue a ThreadPool<Lock> uses
+ */
+template <typename T, typename Lock>
+using PoolQueue = std::conditional_t<std::is_same_v<Lock, LockFree>, MpmcQueue<T>, LockedQueue<T, Lock>>;
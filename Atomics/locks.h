@@ -0,0 +1,364 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "cpu_relax.h"
+#include "../Threading/pool_stats.h"
+
+/**
+ * A family of RAII locks that are all used the same way as WaitOnFlag:
+ *
+ *     Lock::Mutex m_lock;          //the shared lock state
+ *     ...
+ *     {
+ *         Lock wait(m_lock);       //acquired here
+ *         ...
+ *     }                            //released here
+ *
+ * so a class can take the lock as a template parameter. Each reports its acquisitions and spins to the current
+ * pool worker (RecordLock in pool_stats.h).
+ */
+
+/**
+ * Exponential backoff for spin loops, doubling the pause between attempts up to a cap
+ */
+class Backoff
+{
+public:
+    static constexpr uint32_t MaxPause{1024};
+
+    void Pause()
+    {
+        for (auto count=0U; count < m_pause; ++count)
+        {
+            CpuRelax();
+        }
+        if (m_pause < MaxPause)
+        {
+            m_pause *= 2;
+        }
+    }
+
+private:
+    uint32_t m_pause{1};
+};
+
+/**
+ * An RAII style class implementing a spin-lock using std::atomic_flag. Every attempt is a test_and_set, so all
+ * spinners keep stealing the cache line from each other (and from the owner).
+ */
+class WaitOnFlag
+{
+    public:
+        using Mutex = std::atomic_flag;
+
+        WaitOnFlag()=delete;
+        WaitOnFlag(WaitOnFlag const&) = delete;
+        WaitOnFlag(std::atomic_flag& flag) : m_flag(flag)
+        {
+            uint64_t spins{0};
+            while (m_flag.test_and_set()) {++spins;} //block till we win
+            RecordLock(spins);
+        }
+        ~WaitOnFlag()
+        {
+            m_flag.clear();
+        }
+    private:
+        std::atomic_flag& m_flag;
+};
+
+/**
+ * Test-and-test-and-set: spin on a plain load, which is served from our own cache, and only try the exchange
+ * once the lock looks free. Failed exchanges back off exponentially.
+ */
+class TtasLock
+{
+public:
+    struct Mutex
+    {
+        std::atomic<bool> m_locked{false};
+    };
+
+    TtasLock() = delete;
+    TtasLock(TtasLock const&) = delete;
+    TtasLock(Mutex& mutex) : m_mutex(mutex)
+    {
+        uint64_t spins{0};
+        Backoff backoff;
+        while (true)
+        {
+            while (m_mutex.m_locked.load(std::memory_order_relaxed))
+            {
+                CpuRelax();
+                ++spins;
+            }
+            if (!m_mutex.m_locked.exchange(true, std::memory_order_acquire))
+            {
+                break;
+            }
+            backoff.Pause();
+            ++spins;
+        }
+        RecordLock(spins);
+    }
+    ~TtasLock()
+    {
+        m_mutex.m_locked.store(false, std::memory_order_release);
+    }
+
+private:
+    Mutex& m_mutex;
+};
+
+/**
+ * A ticket lock: FIFO fair. Each acquirer takes a ticket and waits for it to be served, backing off in
+ * proportion to how many are ahead of it.
+ */
+class TicketLock
+{
+public:
+    struct Mutex
+    {
+        alignas(64) std::atomic<uint32_t> m_next{0};
+        alignas(64) std::atomic<uint32_t> m_serving{0};
+    };
+
+    TicketLock() = delete;
+    TicketLock(TicketLock const&) = delete;
+    TicketLock(Mutex& mutex) : m_mutex(mutex)
+    {
+        uint64_t spins{0};
+        auto ticket = m_mutex.m_next.fetch_add(1, std::memory_order_relaxed);
+        while (true)
+        {
+            auto serving = m_mutex.m_serving.load(std::memory_order_acquire);
+            if (serving == ticket)
+            {
+                break;
+            }
+            for (auto count=0U; count < (ticket - serving) * 32; ++count)
+            {
+                CpuRelax();
+            }
+            ++spins;
+        }
+        RecordLock(spins);
+    }
+    ~TicketLock()
+    {
+        m_mutex.m_serving.store(m_mutex.m_serving.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    Mutex& m_mutex;
+};
+
+/**
+ * The MCS queue lock: FIFO fair, and every waiter spins on a flag in its own queue node (which lives in the
+ * guard, on the waiter's stack), so a release touches exactly one other cache.
+ */
+class McsLock
+{
+public:
+    struct alignas(64) Node
+    {
+        std::atomic<Node*> m_next{nullptr};
+        std::atomic<bool> m_locked{false};
+    };
+
+    struct Mutex
+    {
+        std::atomic<Node*> m_tail{nullptr};
+    };
+
+    McsLock() = delete;
+    McsLock(McsLock const&) = delete;
+    McsLock(Mutex& mutex) : m_mutex(mutex)
+    {
+        uint64_t spins{0};
+        m_node.m_locked.store(true, std::memory_order_relaxed);
+        auto prev = m_mutex.m_tail.exchange(&m_node, std::memory_order_acq_rel);
+        if (prev)
+        {
+            prev->m_next.store(&m_node, std::memory_order_release);
+            while (m_node.m_locked.load(std::memory_order_acquire))
+            {
+                CpuRelax();
+                ++spins;
+            }
+        }
+        RecordLock(spins);
+    }
+    ~McsLock()
+    {
+        auto next = m_node.m_next.load(std::memory_order_acquire);
+        if (!next)
+        {
+            auto expected = &m_node;
+            if (m_mutex.m_tail.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel))
+            {
+                return; //nobody waiting
+            }
+            //a successor swapped itself in but hasn't linked to us yet
+            while (!(next = m_node.m_next.load(std::memory_order_acquire)))
+            {
+                CpuRelax();
+            }
+        }
+        next->m_locked.store(false, std::memory_order_release);
+    }
+
+private:
+    Mutex& m_mutex;
+    Node m_node;
+};
+
+/**
+ * The CLH queue lock: FIFO fair, each waiter spins on its predecessor's node. Unlike MCS the node a holder
+ * enqueued is still read by its successor after release, so nodes can't live on the stack. Each thread keeps a
+ * small free list instead, and on release swaps its node for its predecessor's, which nobody reads any more.
+ */
+class ClhLock
+{
+public:
+    struct alignas(64) Node
+    {
+        std::atomic<bool> m_locked{false};
+    };
+
+    struct Mutex
+    {
+        Mutex() : m_tail{new Node} {}
+        Mutex(Mutex const&) = delete;
+        ~Mutex() {delete m_tail.load();}
+
+        std::atomic<Node*> m_tail; //always points at a node, released or not
+    };
+
+    ClhLock() = delete;
+    ClhLock(ClhLock const&) = delete;
+    ClhLock(Mutex& mutex) : m_node{TakeNode()}
+    {
+        uint64_t spins{0};
+        m_node->m_locked.store(true, std::memory_order_relaxed);
+        m_pred = mutex.m_tail.exchange(m_node, std::memory_order_acq_rel);
+        while (m_pred->m_locked.load(std::memory_order_acquire))
+        {
+            CpuRelax();
+            ++spins;
+        }
+        RecordLock(spins);
+    }
+    ~ClhLock()
+    {
+        m_node->m_locked.store(false, std::memory_order_release);
+        FreeNodes().emplace_back(m_pred);
+    }
+
+private:
+    static std::vector<std::unique_ptr<Node>>& FreeNodes()
+    {
+        thread_local std::vector<std::unique_ptr<Node>> nodes;
+        return nodes;
+    }
+
+    static Node* TakeNode()
+    {
+        auto& nodes = FreeNodes();
+        if (nodes.empty())
+        {
+            return new Node;
+        }
+        auto node = nodes.back().release();
+        nodes.pop_back();
+        return node;
+    }
+
+    Node* m_node; //ours, handed to the lock (and on to our successor)
+    Node* m_pred; //our predecessor's, ours once we release
+};
+
+/**
+ * Spin for a while, then sleep in the kernel (a futex, via std::atomic::wait) until the holder wakes us.
+ * State is 0 unlocked, 1 locked, 2 locked and somebody may be asleep; only a release from 2 pays for a wake.
+ */
+class HybridLock
+{
+public:
+    static constexpr int SpinCount{100};
+
+    struct Mutex
+    {
+        std::atomic<uint32_t> m_state{0};
+    };
+
+    HybridLock() = delete;
+    HybridLock(HybridLock const&) = delete;
+    HybridLock(Mutex& mutex) : m_mutex(mutex)
+    {
+        uint64_t spins{0};
+        for (auto count=0; count < SpinCount; ++count)
+        {
+            uint32_t expected{0};
+            if (m_mutex.m_state.load(std::memory_order_relaxed) == 0 &&
+                m_mutex.m_state.compare_exchange_weak(expected, 1, std::memory_order_acquire))
+            {
+                RecordLock(spins);
+                return;
+            }
+            CpuRelax();
+            ++spins;
+        }
+        //from here on we always claim the lock as 2, we can't know if there are other sleepers
+        while (m_mutex.m_state.exchange(2, std::memory_order_acquire) != 0)
+        {
+            m_mutex.m_state.wait(2, std::memory_order_relaxed);
+            ++spins;
+        }
+        RecordLock(spins);
+    }
+    ~HybridLock()
+    {
+        if (m_mutex.m_state.exchange(0, std::memory_order_release) == 2)
+        {
+            m_mutex.m_state.notify_one();
+        }
+    }
+
+private:
+    Mutex& m_mutex;
+};
+
+/**
+ * std::mutex in the same shape, as the baseline
+ */
+class StdMutexLock
+{
+public:
+    using Mutex = std::mutex;
+
+    StdMutexLock() = delete;
+    StdMutexLock(StdMutexLock const&) = delete;
+    StdMutexLock(Mutex& mutex) : m_mutex(mutex)
+    {
+        uint64_t spins{0};
+        if (!m_mutex.try_lock())
+        {
+            spins = 1;
+            m_mutex.lock();
+        }
+        RecordLock(spins);
+    }
+    ~StdMutexLock()
+    {
+        m_mutex.unlock();
+    }
+
+private:
+    Mutex& m_mutex;
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * A bounded, lock-free, multi-producer/multi-consumer ring buffer (after Dmitry Vyukov's design).
+ *
+ * Every slot carries a sequence number that says whose turn it is:
+ *  - sequence == pos       the slot is free for the producer that claims position pos
+ *  - sequence == pos + 1   the slot holds the value for the consumer that claims position pos
+ * Producers and consumers claim positions with a CAS on m_tail and m_head respectively, then publish by
+ * bumping the slot sequence. Nobody ever waits on another thread while holding a position, so there is no
+ * lock, and producers and consumers only meet on the slot they both touch.
+ *
+ * T must be default constructible and move assignable.
+ */
+template <typename T>
+class MpmcQueue
+{
+public:
+    MpmcQueue() = delete;
+    MpmcQueue(MpmcQueue const&) = delete;
+
+    /**
+     * capacity is rounded up to a power of two
+     */
+    explicit MpmcQueue(size_t capacity)
+    {
+        size_t size{2};
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        m_mask = size - 1;
+        m_slots = std::make_unique<Slot[]>(size);
+        for (auto count=0U; count < size; ++count)
+        {
+            m_slots[count].m_sequence.store(count, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Returns false if the queue is full. value is only moved from on success.
+     */
+    bool TryPush(T&& value)
+    {
+        auto pos = m_tail.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Slot& slot = m_slots[pos & m_mask];
+            auto seq = slot.m_sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    slot.m_value = std::move(value);
+                    slot.m_sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+                //lost the race, pos now holds the current tail
+            }
+            else if (diff < 0)
+            {
+                return false; //the consumer of the previous lap hasn't released this slot, we are full
+            }
+            else
+            {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Returns false if the queue is empty (or the next value is still being written)
+     */
+    bool TryPop(T& out)
+    {
+        auto pos = m_head.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Slot& slot = m_slots[pos & m_mask];
+            auto seq = slot.m_sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    out = std::move(slot.m_value);
+                    slot.m_value = T{};
+                    slot.m_sequence.store(pos + m_mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Approximate number of queued items, only exact when nobody is pushing or popping
+     */
+    size_t Size() const
+    {
+        auto tail = m_tail.load(std::memory_order_relaxed);
+        auto head = m_head.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t Capacity() const {return m_mask + 1;}
+
+private:
+    static constexpr size_t CacheLine{64};
+
+    struct alignas(CacheLine) Slot
+    {
+        std::atomic<size_t> m_sequence;
+        T m_value;
+    };
+
+    alignas(CacheLine) std::atomic<size_t> m_head{0}; //next position to pop, owned by consumers
+    alignas(CacheLine) std::atomic<size_t> m_tail{0}; //next position to push, owned by producers
+    alignas(CacheLine) std::unique_ptr<Slot[]> m_slots;
+    size_t m_mask;
+};
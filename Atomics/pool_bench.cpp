@@ -0,0 +1,41 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <algorithm>
+
+#include "atomic_pool.h"
+#include "../Threading/bench.h"
+#include "../Threading/pool_workloads.h"
+
+/**
+ * Times the atomics ThreadPool, with the lock-free queue and with a mutex guarded one, at 1, 2, 4, ... threads on
+ * the same workloads as the Threading pool (see ../Threading/pool_workloads.h)
+ */
+
+template <typename Lock>
+void BenchLock(BenchSuite& suite, std::string const& name, size_t maxThreads, size_t tasks, uint64_t primeLimit)
+{
+    for (auto threads: ThreadCounts(maxThreads))
+    {
+        ThreadPool<Lock> pool{threads};
+        pool.Start();
+        BenchPool(suite, "atomics/" + name, pool, threads, tasks, primeLimit);
+        pool.Stop();
+    }
+}
+
+/**
+ * Takes the highest thread count (default one per hardware thread), the number of tasks (default 10^5) and the
+ * prime limit (default 2 * 10^6), and the options in bench.h
+ */
+int main(int argc, char* argv[])
+{
+    BenchSuite suite{"atomic_pool", argc, argv};
+    size_t maxThreads = suite.Arg(0, std::max(1U, std::thread::hardware_concurrency()));
+    size_t tasks = suite.Arg(1, 100000);
+    uint64_t primeLimit = suite.Arg(2, 2000000);
+
+    BenchLock<LockFree>(suite, "lockfree", maxThreads, tasks, primeLimit);
+    BenchLock<StdMutexLock>(suite, "mutex", maxThreads, tasks, primeLimit);
+    return suite.Finish();
+}
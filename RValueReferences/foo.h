@@ -0,0 +1,109 @@
+#pragma once
+
+#include <iostream>
+#include <cstring>
+
+/**
+ * A string owning class that reports which of its constructors and assignments run, to explore R-value references
+ * and move semantics
+ */
+class Foo
+{
+    public:
+        Foo()
+        {
+            Trace("Default CTOR");
+        }
+
+        Foo(Foo const& ref)
+        {
+            Trace("Copy Ctor");
+            m_size = ref.m_size;
+            m_msg = new char[m_size+1];
+            if (ref.m_msg) //moved from
+            {
+                strncpy(m_msg, ref.m_msg, m_size);
+            }
+            m_msg[m_size] = '\0';
+        }
+        Foo(Foo&& ref)
+        {
+            Trace("Move CTOR");
+            m_size = ref.m_size;
+            m_msg = ref.m_msg;
+            ref.m_size = 0;
+            ref.m_msg = nullptr;
+        }
+
+        Foo(const char* msg)
+        {
+            Trace("CTOR");
+            m_size = strlen(msg);
+            m_msg = new char[m_size+1];
+            strncpy(m_msg, msg, m_size);
+            m_msg[m_size] = '\0';
+        }
+
+
+        Foo& operator=(Foo const& ref)
+        {
+            Trace("Assignment Operator");
+            if (m_msg)
+            {
+                delete [] m_msg;
+            }
+            m_size = ref.m_size;
+            m_msg = new char[m_size+1];
+            if (ref.m_msg) //moved from
+            {
+                strncpy(m_msg, ref.m_msg, m_size);
+            }
+            m_msg[m_size] = '\0';
+
+            return *this;
+        }
+
+        Foo& operator=(Foo&& ref)
+        {
+            Trace("Move Operator");
+            if (m_msg)
+            {
+                delete [] m_msg;
+            }
+            m_size = ref.m_size;
+            m_msg = ref.m_msg;
+            ref.m_size = 0;
+            ref.m_msg = nullptr;
+            return *this;
+        }
+
+
+        void Print(std::ostream& os) const {if (m_size) os << m_msg;}
+
+        /**
+         * Whether the constructors and assignments announce themselves on std::cout (they do unless a benchmark
+         * turns it off)
+         */
+        inline static bool s_trace{true};
+
+        ~Foo()
+        {
+            if (m_msg) 
+            {
+                delete [] m_msg;
+            }
+        }
+
+    private:
+        static void Trace(char const* what)
+        {
+            if (s_trace)
+            {
+                std::cout << what << std::endl;
+            }
+        }
+
+        size_t m_size{0};
+        char* m_msg{nullptr};
+};
+inline std::ostream& operator<<(std::ostream& os, Foo const& ref) { ref.Print(os); return os;}
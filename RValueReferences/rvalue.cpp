@@ -3,89 +3,12 @@
 #include <iostream>
 #include <cstring>
 
+#include "foo.h"
+
 /**
  * Explore R-value references and move semantics
  */
 
-class Foo
-{
-    public:
-        Foo()
-        {
-            std::cout << "Default CTOR" << std::endl;
-        }
-
-        Foo(Foo const& ref)
-        {
-            std::cout << "Copy Ctor" << std::endl;
-            m_size = ref.m_size;
-            m_msg = new char[m_size+1];
-            strncpy(m_msg, ref.m_msg, m_size);
-        }
-        Foo(Foo&& ref)
-        {
-            std::cout << "Move CTOR" << std::endl;
-            m_size = ref.m_size;
-            m_msg = ref.m_msg;
-            ref.m_size = 0;
-            ref.m_msg = nullptr;
-        }
-
-        Foo(const char* msg)
-        {
-            std::cout << "CTOR" << std::endl;
-            m_size = strlen(msg);
-            m_msg = new char[m_size+1];
-            strncpy(m_msg, msg, m_size);
-        }
-
-
-        Foo& operator=(Foo const& ref)
-        {
-            std::cout << "Assignment Operator" << std::endl;
-            if (m_msg)
-            {
-                delete [] m_msg;
-            }
-            m_size = ref.m_size;
-            m_msg = new char[m_size+1];
-            strncpy(m_msg, ref.m_msg, m_size);
-
-            return *this;
-        }
-
-        Foo& operator=(Foo&& ref)
-        {
-            std::cout << "Move Operator" << std::endl;
-            if (m_msg)
-            {
-                delete [] m_msg;
-            }
-            m_size = ref.m_size;
-            m_msg = ref.m_msg;
-            ref.m_size = 0;
-            ref.m_msg = nullptr;
-            return *this;
-        }
-
-
-        void Print(std::ostream& os) const {if (m_size) os << m_msg;}
-
-        ~Foo()
-        {
-            if (m_msg) 
-            {
-                delete m_msg;
-            }
-        }
-
-    private:
-        size_t m_size{0};
-        char* m_msg{nullptr};
-};
-std::ostream& operator<<(std::ostream& os, Foo const& ref) { ref.Print(os); return os;}
-
-
 int main(void)
 {
     //Playing with constructors
@@ -0,0 +1,88 @@
+#include <utility>
+#include <vector>
+#include <string>
+#include <iostream>
+
+#include "foo.h"
+#include "../Threading/bench.h"
+
+/**
+ * Times Foo's copy and move paths with the tracing turned off: construction, assignment, and filling and growing a
+ * std::vector, which only moves its elements when the move constructor is noexcept
+ */
+
+/**
+ * Takes the number of objects per run (default 10^6) and the message length (default 64), and the options in
+ * bench.h
+ */
+int main(int argc, char* argv[])
+{
+    BenchSuite suite{"rvalue", argc, argv};
+    size_t count = suite.Arg(0, 1000000);
+    std::string message(suite.Arg(1, 64), 'x');
+
+    Foo::s_trace = false;
+    std::vector<Foo> sources;
+    sources.reserve(count);
+    for (auto idx=0U; idx < count; ++idx)
+    {
+        sources.emplace_back(message.c_str());
+    }
+    std::vector<Foo> targets(count);
+    //the moves leave sources empty, so every case that reads them starts from fresh ones
+    auto refill = [&]{
+        for (auto& cur: sources)
+        {
+            cur = Foo{message.c_str()};
+        }
+    };
+
+    suite.RunWithSetup("construct/copy", refill, [&]{
+        for (auto& cur: sources)
+        {
+            Foo copy{cur};
+            DoNotOptimize(copy);
+        }
+    }, count);
+    suite.RunWithSetup("construct/move", refill, [&]{
+        for (auto& cur: sources)
+        {
+            Foo moved{std::move(cur)};
+            DoNotOptimize(moved);
+        }
+    }, count);
+    suite.RunWithSetup("assign/copy", refill, [&]{
+        for (auto idx=0U; idx < count; ++idx)
+        {
+            targets[idx] = sources[idx];
+        }
+    }, count);
+    suite.RunWithSetup("assign/move", refill, [&]{
+        for (auto idx=0U; idx < count; ++idx)
+        {
+            targets[idx] = std::move(sources[idx]);
+        }
+    }, count);
+    suite.RunWithSetup("vector/push_back_copy", refill, [&]{
+        std::vector<Foo> items;
+        for (auto& cur: sources)
+        {
+            items.push_back(cur);
+        }
+    }, count);
+    suite.RunWithSetup("vector/push_back_move", refill, [&]{
+        std::vector<Foo> items;
+        for (auto& cur: sources)
+        {
+            items.push_back(std::move(cur));
+        }
+    }, count);
+    suite.Run("vector/emplace_back", [&]{
+        std::vector<Foo> items;
+        for (auto idx=0U; idx < count; ++idx)
+        {
+            items.emplace_back(message.c_str());
+        }
+    }, count);
+    return suite.Finish();
+}
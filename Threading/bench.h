@@ -0,0 +1,287 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * The harness every *_bench program reports through, so results from all the directories can be compared and
+ * checked for regressions the same way:
+ *
+ *     BenchSuite suite{"primality", argc, argv};
+ *     suite.Run("isprime/odd64", [&]{...}, values.size());
+ *     return suite.Finish();
+ *
+ * Each case is run untimed WarmUp times, then timed up to Repetitions times (stopping early once the case has used
+ * its time budget, but never before MinRepetitions). Min, median, p99 and mean are printed as each case finishes.
+ *
+ * Command line options, removed before the program sees its own arguments (Args()):
+ *   --reps N          timed repetitions per case (default 10)
+ *   --warmup N        untimed runs first (default 1)
+ *   --budget SECONDS  stop repeating a case once it has used this much (default 2)
+ *   --filter TEXT     only run cases whose name contains TEXT
+ *   --json PATH       also write the results as JSON
+ *   --baseline PATH   compare medians with a JSON file from an earlier run, and fail if any got slower than
+ *   --tolerance FRAC  the baseline by more than FRAC (default 0.1)
+ */
+
+/**
+ * Stop the compiler from optimizing away value (or the computation of it)
+ */
+template <typename T>
+inline void DoNotOptimize(T const& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * The timings of one case
+ */
+struct BenchResult
+{
+    std::string m_name;
+    size_t m_repetitions{0};
+    double m_minNs{0};
+    double m_medianNs{0};
+    double m_p99Ns{0};
+    double m_meanNs{0};
+    double m_items{1}; //work items per run, for the per item and throughput figures
+};
+
+class BenchSuite
+{
+public:
+    static constexpr size_t MinRepetitions{3};
+
+    BenchSuite() = delete;
+    BenchSuite(BenchSuite const&) = delete;
+    BenchSuite(std::string name, int argc, char* argv[]) : m_name{std::move(name)}
+    {
+        for (auto idx=1; idx < argc; ++idx)
+        {
+            std::string arg{argv[idx]};
+            auto value = [&]() -> std::string {
+                if (idx + 1 >= argc)
+                {
+                    throw std::invalid_argument(arg + " needs a value");
+                }
+                return argv[++idx];
+            };
+            if (arg == "--reps") m_repetitions = std::max<size_t>(std::stoul(value()), 1);
+            else if (arg == "--warmup") m_warmUp = std::stoul(value());
+            else if (arg == "--budget") m_budget = std::stod(value());
+            else if (arg == "--filter") m_filter = value();
+            else if (arg == "--json") m_jsonPath = value();
+            else if (arg == "--baseline") m_baseline = ReadBaseline(value());
+            else if (arg == "--tolerance") m_tolerance = std::stod(value());
+            else m_args.push_back(arg);
+        }
+    }
+
+    /**
+     * The arguments that weren't harness options, without the program name
+     */
+    std::vector<std::string> const& Args() const {return m_args;}
+
+    /**
+     * Positional argument idx as a number, or fallback if there aren't that many
+     */
+    uint64_t Arg(size_t idx, uint64_t fallback) const
+    {
+        return idx < m_args.size() ? std::stoull(m_args[idx]) : fallback;
+    }
+
+    bool Enabled(std::string const& name) const
+    {
+        return m_filter.empty() || name.find(m_filter) != std::string::npos;
+    }
+
+    /**
+     * Time body(), which does items units of work per call
+     */
+    template <typename F>
+    void Run(std::string const& name, F&& body, double items = 1)
+    {
+        RunWithSetup(name, []{}, body, items);
+    }
+
+    /**
+     * As Run, but call setup() untimed before every run of body(), e.g. to reshuffle what body sorts
+     */
+    template <typename Setup, typename F>
+    void RunWithSetup(std::string const& name, Setup&& setup, F&& body, double items = 1)
+    {
+        if (!Enabled(name))
+        {
+            return;
+        }
+        if (m_results.empty())
+        {
+            Header();
+        }
+        for (auto idx=0U; idx < m_warmUp; ++idx)
+        {
+            setup();
+            body();
+        }
+
+        std::vector<double> samples;
+        double spent{0};
+        while (samples.size() < m_repetitions && (samples.size() < MinRepetitions || spent < m_budget * 1e9))
+        {
+            setup();
+            auto start = std::chrono::steady_clock::now();
+            body();
+            samples.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+            spent += samples.back();
+        }
+
+        std::sort(samples.begin(), samples.end());
+        BenchResult result;
+        result.m_name = name;
+        result.m_repetitions = samples.size();
+        result.m_minNs = samples.front();
+        result.m_medianNs = samples.size() % 2 ? samples[samples.size() / 2]
+                                               : (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) / 2;
+        result.m_p99Ns = samples[std::min(samples.size() - 1, static_cast<size_t>(std::ceil(0.99 * samples.size())) - 1)];
+        result.m_meanNs = spent / samples.size();
+        result.m_items = std::max(items, 1.0);
+        m_results.push_back(result);
+        Print(result);
+    }
+
+    /**
+     * Record a failed correctness check, which makes Finish return non-zero
+     */
+    void Check(bool ok, std::string const& what)
+    {
+        if (!ok)
+        {
+            std::cout << "FAILED: " << what << std::endl;
+            m_failed = true;
+        }
+    }
+
+    std::vector<BenchResult> const& Results() const {return m_results;}
+
+    /**
+     * Write the JSON file if asked for, and return the exit code: 0 unless a check failed or a case regressed
+     * against the baseline
+     */
+    int Finish()
+    {
+        if (!m_jsonPath.empty())
+        {
+            std::ofstream out{m_jsonPath};
+            WriteJson(out);
+            if (!out)
+            {
+                std::cout << "Unable to write " << m_jsonPath << std::endl;
+                m_failed = true;
+            }
+        }
+        if (m_regressions != 0)
+        {
+            std::cout << m_regressions << " case(s) slower than the baseline by more than "
+                      << std::setprecision(0) << m_tolerance * 100 << "%" << std::endl;
+        }
+        return (m_failed || m_regressions != 0) ? 1 : 0;
+    }
+
+    /**
+     * One result per line, which is also what ReadBaseline expects
+     */
+    void WriteJson(std::ostream& os) const
+    {
+        os << "{\"suite\": \"" << m_name << "\", \"hardware_threads\": " << std::thread::hardware_concurrency()
+           << ", \"results\": [" << std::endl;
+        for (auto idx=0U; idx < m_results.size(); ++idx)
+        {
+            auto const& cur = m_results[idx];
+            os << std::fixed << std::setprecision(1)
+               << "  {\"name\": \"" << cur.m_name << "\", \"repetitions\": " << cur.m_repetitions
+               << ", \"min_ns\": " << cur.m_minNs << ", \"median_ns\": " << cur.m_medianNs << ", \"p99_ns\": " << cur.m_p99Ns
+               << ", \"mean_ns\": " << cur.m_meanNs << ", \"items\": " << cur.m_items
+               << ", \"items_per_sec\": " << cur.m_items * 1e9 / cur.m_medianNs << "}"
+               << (idx + 1 < m_results.size() ? "," : "") << std::endl;
+        }
+        os << "]}" << std::endl;
+    }
+
+private:
+    /**
+     * Case name to median from a file written by WriteJson. Only that layout is understood, this isn't a JSON parser.
+     */
+    static std::map<std::string, double> ReadBaseline(std::string const& path)
+    {
+        std::ifstream in{path};
+        if (!in)
+        {
+            throw std::runtime_error("Unable to read baseline " + path);
+        }
+        std::map<std::string, double> medians;
+        std::string line;
+        while (std::getline(in, line))
+        {
+            auto name = line.find("\"name\": \"");
+            auto median = line.find("\"median_ns\": ");
+            if (name == std::string::npos || median == std::string::npos)
+            {
+                continue;
+            }
+            name += 9;
+            medians[line.substr(name, line.find('"', name) - name)] = std::stod(line.substr(median + 13));
+        }
+        return medians;
+    }
+
+    void Header() const
+    {
+        std::cout << std::left << std::setw(40) << m_name << std::right << std::setw(6) << "reps" << std::setw(12) << "min ms"
+                  << std::setw(12) << "median ms" << std::setw(12) << "p99 ms" << std::setw(12) << "ns/item"
+                  << std::setw(12) << "Mitems/s" << (m_baseline.empty() ? "" : "     vs base") << std::endl;
+    }
+
+    void Print(BenchResult const& result)
+    {
+        std::cout << std::left << std::setw(40) << result.m_name << std::right << std::setw(6) << result.m_repetitions
+                  << std::fixed << std::setprecision(3) << std::setw(12) << result.m_minNs / 1e6
+                  << std::setw(12) << result.m_medianNs / 1e6 << std::setw(12) << result.m_p99Ns / 1e6
+                  << std::setprecision(1) << std::setw(12) << result.m_medianNs / result.m_items
+                  << std::setprecision(2) << std::setw(12) << result.m_items * 1e3 / result.m_medianNs;
+        auto base = m_baseline.find(result.m_name);
+        if (base != m_baseline.end() && base->second > 0)
+        {
+            auto change = result.m_medianNs / base->second - 1;
+            std::cout << std::setprecision(1) << std::setw(11) << std::showpos << change * 100 << "%" << std::noshowpos;
+            if (change > m_tolerance)
+            {
+                std::cout << " REGRESSION";
+                ++m_regressions;
+            }
+        }
+        std::cout << std::endl;
+    }
+
+    std::string m_name;
+    std::vector<std::string> m_args;
+    size_t m_repetitions{10};
+    size_t m_warmUp{1};
+    double m_budget{2.0}; //seconds per case
+    std::string m_filter;
+    std::string m_jsonPath;
+    std::map<std::string, double> m_baseline; //case name to median ns
+    double m_tolerance{0.1};
+    std::vector<BenchResult> m_results;
+    size_t m_regressions{0};
+    bool m_failed{false};
+};
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <algorithm>
+
+#include "primality.h"
+
+/**
+ * A factorization: (prime, exponent) pairs in increasing order of prime
+ */
+using PrimePowers = std::vector<std::pair<uint64_t, unsigned>>;
+
+/**
+ * The number of odd primes below limit
+ */
+constexpr size_t CountTrialPrimes(uint32_t limit)
+{
+    size_t count{0};
+    for (uint32_t value=3; value < limit; value += 2)
+    {
+        bool prime{true};
+        for (uint32_t div=3; div * div <= value; div += 2)
+        {
+            prime = prime && value % div != 0;
+        }
+        count += prime ? 1 : 0;
+    }
+    return count;
+}
+
+/**
+ * Factoring any 64 bit number:
+ *  - factors of 2 come off with a shift, then trial division by the odd primes below TrialLimit. Whether p divides
+ *    value is tested with a multiplication by p's inverse mod 2^64 rather than a division: value * p^-1 is at most
+ *    (2^64 - 1) / p exactly when it does.
+ *  - what is left is 1, a prime (below TrialLimit^2, or passing Primality::IsPrime) or a composite, which Pollard's
+ *    rho with Brent's cycle detection splits in two. The walk runs in Montgomery form (32 bit when it fits), and
+ *    the differences are multiplied together so only every BatchSteps steps pay for a gcd.
+ */
+class Factorizer
+{
+public:
+    static constexpr uint32_t TrialLimit{1024};
+    static constexpr uint32_t BatchSteps{128};
+
+    /**
+     * The prime factors of value with their exponents, empty for 0 and 1
+     */
+    static PrimePowers Factor(uint64_t value)
+    {
+        PrimePowers factors;
+        if (value < 2)
+        {
+            return factors;
+        }
+        if (auto twos = static_cast<unsigned>(__builtin_ctzll(value)))
+        {
+            factors.emplace_back(2, twos);
+            value >>= twos;
+        }
+        for (auto& trial: TrialPrimes())
+        {
+            if (trial.m_prime * trial.m_prime > value)
+            {
+                break;
+            }
+            unsigned exponent{0};
+            while (value * trial.m_inverse <= trial.m_maxQuotient)
+            {
+                value *= trial.m_inverse; //exact division
+                ++exponent;
+            }
+            if (exponent != 0)
+            {
+                factors.emplace_back(trial.m_prime, exponent);
+            }
+        }
+        if (value == 1)
+        {
+            return factors;
+        }
+
+        std::vector<uint64_t> primes;
+        Split(value, primes);
+        std::sort(primes.begin(), primes.end());
+        for (auto prime: primes)
+        {
+            if (!factors.empty() && factors.back().first == prime)
+            {
+                ++factors.back().second;
+            }
+            else
+            {
+                factors.emplace_back(prime, 1);
+            }
+        }
+        return factors;
+    }
+
+    /**
+     * Factor every one of values on pool, results in the same order
+     */
+    template <typename Pool>
+    static std::vector<PrimePowers> FactorAll(std::vector<uint64_t> const& values, Pool& pool)
+    {
+        std::vector<PrimePowers> results(values.size());
+        pool.ParallelFor(0, values.size(), 0, [&](size_t idx){results[idx] = Factor(values[idx]);});
+        return results;
+    }
+
+private:
+    struct TrialPrime
+    {
+        uint64_t m_prime;
+        uint64_t m_inverse; //m_prime^-1 mod 2^64
+        uint64_t m_maxQuotient; //(2^64 - 1) / m_prime
+    };
+
+    static constexpr std::array<TrialPrime, CountTrialPrimes(TrialLimit)> MakeTrialPrimes()
+    {
+        std::array<TrialPrime, CountTrialPrimes(TrialLimit)> primes{};
+        size_t idx{0};
+        for (uint32_t value=3; value < TrialLimit; value += 2)
+        {
+            bool prime{true};
+            for (uint32_t div=3; div * div <= value; div += 2)
+            {
+                prime = prime && value % div != 0;
+            }
+            if (prime)
+            {
+                uint64_t inverse{value}; //Newton's iteration, as in Montgomery
+                for (auto bits=3U; bits < 64; bits *= 2)
+                {
+                    inverse *= 2 - value * inverse;
+                }
+                primes[idx++] = TrialPrime{value, inverse, UINT64_MAX / value};
+            }
+        }
+        return primes;
+    }
+
+    static std::array<TrialPrime, CountTrialPrimes(TrialLimit)> const& TrialPrimes()
+    {
+        static constexpr auto primes = MakeTrialPrimes();
+        return primes;
+    }
+
+    /**
+     * Add the prime factors of value, which is odd and has none below TrialLimit, to primes
+     */
+    static void Split(uint64_t value, std::vector<uint64_t>& primes)
+    {
+        if (value < uint64_t{TrialLimit} * TrialLimit || Primality::IsPrime(value))
+        {
+            primes.push_back(value);
+            return;
+        }
+        auto divisor = value <= UINT32_MAX ? FindDivisor<uint32_t, uint64_t>(static_cast<uint32_t>(value))
+                                           : FindDivisor<uint64_t, unsigned __int128>(value);
+        Split(divisor, primes);
+        Split(value / divisor, primes);
+    }
+
+    /**
+     * A non-trivial divisor of the odd composite n: Pollard's rho walking x -> x^2 + c, with Brent's doubling cycle
+     * detection. If a batched gcd overshoots to n, the batch is replayed one step at a time; if even that only finds
+     * n, the walk restarts with the next c.
+     */
+    template <typename UInt, typename Wide>
+    static UInt FindDivisor(UInt n)
+    {
+        Montgomery<UInt, Wide> mont{n};
+        for (UInt c=1; ; ++c)
+        {
+            auto add = mont.ToMont(c);
+            auto next = [&](UInt x) {
+                auto square = mont.Multiply(x, x);
+                return square >= n - add ? square - (n - add) : square + add;
+            };
+            auto distance = [](UInt lhs, UInt rhs) {return lhs > rhs ? lhs - rhs : rhs - lhs;};
+
+            UInt x{0};
+            UInt y = mont.One();
+            UInt saved{0}; //y at the start of the last batch
+            UInt product = mont.One();
+            UInt divisor{1};
+            for (UInt length=1; divisor == 1; length *= 2)
+            {
+                x = y;
+                for (UInt step=0; step < length; ++step)
+                {
+                    y = next(y);
+                }
+                for (UInt done=0; done < length && divisor == 1; done += BatchSteps)
+                {
+                    saved = y;
+                    auto steps = std::min<UInt>(BatchSteps, length - done);
+                    for (UInt step=0; step < steps; ++step)
+                    {
+                        y = next(y);
+                        product = mont.Multiply(product, distance(x, y));
+                    }
+                    divisor = Gcd(product, n);
+                }
+            }
+            if (divisor == n)
+            {
+                do
+                {
+                    saved = next(saved);
+                    divisor = Gcd(distance(x, saved), n);
+                } while (divisor == 1);
+            }
+            if (divisor != n)
+            {
+                return divisor;
+            }
+        }
+    }
+
+    /**
+     * Binary gcd, shifts and subtractions instead of divisions
+     */
+    template <typename UInt>
+    static UInt Gcd(UInt lhs, UInt rhs)
+    {
+        if (lhs == 0 || rhs == 0)
+        {
+            return lhs | rhs;
+        }
+        auto shift = __builtin_ctzll(lhs | rhs);
+        lhs >>= __builtin_ctzll(lhs);
+        do
+        {
+            rhs >>= __builtin_ctzll(rhs);
+            if (lhs > rhs)
+            {
+                std::swap(lhs, rhs);
+            }
+            rhs -= lhs;
+        } while (rhs != 0);
+        return lhs << shift;
+    }
+};
@@ -0,0 +1,166 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <string>
+#include <thread>
+#include <cstdint>
+
+#include "factor.h"
+#include "thread_pool.h"
+#include "bench.h"
+
+/**
+ * Cross-checks Factorizer::Factor, then times factoring random semiprimes, on one thread and spread over a
+ * ThreadPool
+ */
+
+/**
+ * Trial division up to sqrt(val), slow but obviously right
+ */
+PrimePowers TrialFactor(uint64_t val)
+{
+    PrimePowers factors;
+    for (uint64_t div=2; div * div <= val; ++div)
+    {
+        unsigned exponent{0};
+        while (val % div == 0)
+        {
+            val /= div;
+            ++exponent;
+        }
+        if (exponent != 0)
+        {
+            factors.emplace_back(div, exponent);
+        }
+    }
+    if (val > 1)
+    {
+        factors.emplace_back(val, 1);
+    }
+    return factors;
+}
+
+/**
+ * The factors are prime, increasing, and multiply back to val
+ */
+bool Consistent(uint64_t val, PrimePowers const& factors)
+{
+    unsigned __int128 product{1};
+    for (auto idx=0U; idx < factors.size(); ++idx)
+    {
+        auto [prime, exponent] = factors[idx];
+        if (!Primality::IsPrime(prime) || exponent == 0 || (idx != 0 && factors[idx - 1].first >= prime))
+        {
+            return false;
+        }
+        for (auto count=0U; count < exponent; ++count)
+        {
+            product *= prime;
+        }
+    }
+    return val < 2 ? factors.empty() : product == val;
+}
+
+uint64_t RandomPrime(std::mt19937_64& rng, unsigned bits)
+{
+    auto val = (rng() >> (64 - bits)) | (1ULL << (bits - 1)) | 1;
+    while (!Primality::IsPrime(val))
+    {
+        val += 2;
+    }
+    return val;
+}
+
+bool CrossCheck(uint64_t exhaustiveLimit)
+{
+    for (uint64_t val=0; val <= exhaustiveLimit; ++val)
+    {
+        if (Factorizer::Factor(val) != TrialFactor(val))
+        {
+            std::cout << "Factor(" << val << ") disagrees with trial division" << std::endl;
+            return false;
+        }
+    }
+
+    std::mt19937_64 rng{42};
+    for (auto count=0; count < 1000; ++count)
+    {
+        auto val = rng() >> 28; //2^36, where trial division is still affordable
+        if (Factorizer::Factor(val) != TrialFactor(val))
+        {
+            std::cout << "Factor(" << val << ") disagrees with trial division" << std::endl;
+            return false;
+        }
+    }
+
+    //random 64 bit numbers, semiprimes and prime powers (including squares of primes above the trial limit) and
+    //the ends of the range
+    std::vector<uint64_t> values{UINT64_MAX, UINT64_MAX - 1, 18446744073709551557ULL, 1ULL << 63,
+                                 4294967291ULL * 4294967279ULL, 1021ULL * 1021 * 1021, 1031ULL * 1031, 65537ULL * 65537 * 65537,
+                                 3825123056546413051ULL, 2305843009213693951ULL, 2ULL * 3 * 5 * 7 * 11 * 13 * 17 * 19 * 23 * 29 * 31 * 37 * 41 * 43 * 47};
+    for (auto count=0; count < 2000; ++count)
+    {
+        values.push_back(rng());
+        values.push_back(RandomPrime(rng, 32) * RandomPrime(rng, 32));
+        values.push_back(RandomPrime(rng, 16) * RandomPrime(rng, 21) * RandomPrime(rng, 26));
+    }
+    for (auto val: values)
+    {
+        if (!Consistent(val, Factorizer::Factor(val)))
+        {
+            std::cout << "Factor(" << val << ") is wrong" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Takes the limit for the exhaustive cross-check (default 10^6), the number of semiprimes per size (default 10^4)
+ * and the threads for the batch run (default one per hardware thread), and the options in bench.h
+ */
+int main(int argc, char* argv[])
+{
+    BenchSuite suite{"factor", argc, argv};
+    uint64_t exhaustiveLimit = suite.Arg(0, 1000000);
+    size_t count = suite.Arg(1, 10000);
+    size_t threads = suite.Arg(2, std::max(1U, std::thread::hardware_concurrency()));
+
+    if (!CrossCheck(exhaustiveLimit))
+    {
+        return -1;
+    }
+    std::cout << "Cross-check passed" << std::endl;
+
+    ThreadPool pool{threads};
+    pool.Start();
+
+    std::mt19937_64 rng{7};
+    for (auto bits: {24U, 32U, 40U, 48U, 56U, 62U})
+    {
+        std::vector<uint64_t> values(count);
+        for (auto& val: values)
+        {
+            val = RandomPrime(rng, bits / 2) * RandomPrime(rng, bits - bits / 2);
+        }
+
+        auto name = "factor/semiprime" + std::to_string(bits);
+        suite.Run(name, [&]{
+            size_t factors{0};
+            for (auto val: values)
+            {
+                factors += Factorizer::Factor(val).size();
+            }
+            DoNotOptimize(factors);
+        }, count);
+        std::vector<PrimePowers> results;
+        suite.Run(name + "/pool" + std::to_string(threads), [&]{results = Factorizer::FactorAll(values, pool);}, count);
+        for (auto idx=0U; idx < results.size(); ++idx)
+        {
+            suite.Check(Consistent(values[idx], results[idx]), "FactorAll of " + std::to_string(values[idx]));
+        }
+    }
+    pool.Stop();
+    return suite.Finish();
+}
@@ -0,0 +1,398 @@
+#pragma once
+
+#include <mutex>
+#include <cassert>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+#include "task.h"
+
+/**
+ * Where a Future runs its continuations and what it can do while waiting. Any pool with AddWork(Task&&) and
+ * RunOne() will do, so the futures don't depend on a particular ThreadPool. A default Executor has no pool:
+ * continuations of its futures run inline on the completing thread.
+ */
+class Executor
+{
+public:
+    Executor() = default;
+
+    template <typename Pool, typename = std::enable_if_t<!std::is_same_v<std::remove_cv_t<Pool>, Executor>>>
+    explicit Executor(Pool& pool)
+        : m_pool{&pool}
+        , m_submit{[](void* pool, Task&& task) {static_cast<Pool*>(pool)->AddWork(std::move(task));}}
+        , m_runOne{[](void* pool) {return static_cast<Pool*>(pool)->RunOne();}}
+    {
+    }
+
+    bool Valid() const {return m_submit != nullptr;}
+    void Submit(Task&& task) const
+    {
+        assert(m_submit && "Submit on an Executor without a pool");
+        m_submit(m_pool, std::move(task));
+    }
+    bool RunOne() const {return m_pool && m_runOne(m_pool);}
+
+private:
+    void* m_pool{nullptr};
+    void (*m_submit)(void*, Task&&){nullptr};
+    bool (*m_runOne)(void*){nullptr};
+};
+
+/**
+ * Tag for the ThreadPool::AddWork overload that returns a Future
+ */
+struct UseFuture {};
+inline constexpr UseFuture useFuture{};
+
+template <typename T> class Future;
+template <typename T> class Promise;
+
+/**
+ * The state shared by a Promise and its Future: the result (or exception) and at most one continuation
+ */
+template <typename T>
+class FutureState
+{
+public:
+    using Value = std::conditional_t<std::is_void_v<T>, bool, T>; //void results are stored as a dummy flag
+
+    explicit FutureState(Executor executor) : m_executor{executor} {}
+    FutureState(FutureState const&) = delete;
+
+    void SetValue(Value&& value)
+    {
+        std::unique_lock<std::mutex> guard{m_mutex};
+        m_value.emplace(std::move(value));
+        Complete(guard);
+    }
+
+    void SetError(std::exception_ptr error)
+    {
+        std::unique_lock<std::mutex> guard{m_mutex};
+        m_error = error;
+        Complete(guard);
+    }
+
+    /**
+     * Call func and store what it returns, or what it throws
+     */
+    template <typename F, typename... Args>
+    void SetFrom(F& func, Args&&... args)
+    {
+        try
+        {
+            if constexpr (std::is_void_v<T>)
+            {
+                func(std::forward<Args>(args)...);
+                SetValue(true);
+            }
+            else
+            {
+                SetValue(func(std::forward<Args>(args)...));
+            }
+        }
+        catch (...)
+        {
+            SetError(std::current_exception());
+        }
+    }
+
+    /**
+     * Run continuation once the result is in: on the pool if onPool is set, otherwise inline on whichever thread
+     * completes the state. If the result is already in, that is now.
+     */
+    void OnReady(Task&& continuation, bool onPool)
+    {
+        {
+            std::lock_guard<std::mutex> guard{m_mutex};
+            if (!m_ready)
+            {
+                m_continuation = std::move(continuation);
+                m_continuationOnPool = onPool;
+                return;
+            }
+        }
+        Dispatch(continuation, onPool);
+    }
+
+    bool Ready() const
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+        return m_ready;
+    }
+
+    /**
+     * Block until the result is in. The waiting thread runs queued pool work first, so waiting on a worker still
+     * makes progress.
+     */
+    void Wait()
+    {
+        while (!Ready())
+        {
+            if (!m_executor.RunOne())
+            {
+                std::unique_lock<std::mutex> guard{m_mutex};
+                m_cond.wait(guard, [&]{return m_ready;});
+            }
+        }
+    }
+
+    Value Take()
+    {
+        Wait();
+        if (m_error)
+        {
+            std::rethrow_exception(m_error);
+        }
+        return std::move(*m_value);
+    }
+
+    std::exception_ptr Error() const {return m_error;} //only valid once Ready
+    Executor const& GetExecutor() const {return m_executor;}
+
+private:
+    void Complete(std::unique_lock<std::mutex>& guard)
+    {
+        m_ready = true;
+        auto continuation = std::move(m_continuation);
+        auto onPool = m_continuationOnPool;
+        guard.unlock();
+        m_cond.notify_all();
+        if (continuation)
+        {
+            Dispatch(continuation, onPool);
+        }
+    }
+
+    void Dispatch(Task& continuation, bool onPool)
+    {
+        if (onPool && m_executor.Valid())
+        {
+            //from a worker this lands on its own deque, so the continuation runs where the data is still hot
+            m_executor.Submit(std::move(continuation));
+        }
+        else
+        {
+            continuation();
+        }
+    }
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_ready{false};
+    std::optional<Value> m_value;
+    std::exception_ptr m_error;
+    Task m_continuation;
+    bool m_continuationOnPool{false};
+    Executor m_executor;
+};
+
+/**
+ * The write end of a Future
+ */
+template <typename T>
+class Promise
+{
+public:
+    explicit Promise(Executor executor) : m_state{std::make_shared<FutureState<T>>(executor)} {}
+
+    Future<T> GetFuture() const {return Future<T>{m_state};}
+
+    template <typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
+    void SetValue(U value) {m_state->SetValue(std::move(value));}
+    template <typename U = T, typename = std::enable_if_t<std::is_void_v<U>>>
+    void SetValue() {m_state->SetValue(true);}
+    void SetError(std::exception_ptr error) {m_state->SetError(error);}
+
+private:
+    std::shared_ptr<FutureState<T>> m_state;
+};
+
+/**
+ * A move-only handle to a result that a pool task will produce. Get blocks; Then chains more work without
+ * blocking anybody.
+ */
+template <typename T>
+class Future
+{
+public:
+    Future() = default;
+    explicit Future(std::shared_ptr<FutureState<T>> state) : m_state{std::move(state)} {}
+    Future(Future const&) = delete;
+    Future(Future&&) = default;
+    Future& operator=(Future&&) = default;
+
+    bool Valid() const {return m_state != nullptr;}
+    bool Ready() const {return m_state->Ready();}
+    void Wait() const {m_state->Wait();}
+
+    /**
+     * Wait for and return the result (rethrowing what the task threw). Consumes the future.
+     */
+    T Get()
+    {
+        auto state = std::move(m_state);
+        if constexpr (std::is_void_v<T>)
+        {
+            state->Take();
+        }
+        else
+        {
+            return state->Take();
+        }
+    }
+
+    /**
+     * Schedule func(result) (func() for a void future) on the pool once this future is ready, and return a future
+     * for what func returns. If this future holds an exception func is skipped and the exception passed on.
+     * Consumes the future.
+     */
+    template <typename F>
+    auto Then(F&& func)
+    {
+        using Result = typename ThenResult<std::decay_t<F>>::type;
+        auto prev = std::move(m_state);
+        auto next = std::make_shared<FutureState<Result>>(prev->GetExecutor());
+        auto raw = prev.get();
+        raw->OnReady([prev = std::move(prev), next, func = std::forward<F>(func)]() mutable {
+            if (prev->Error())
+            {
+                next->SetError(prev->Error());
+            }
+            else if constexpr (std::is_void_v<T>)
+            {
+                next->SetFrom(func);
+            }
+            else
+            {
+                next->SetFrom(func, prev->Take());
+            }
+        }, true);
+        return Future<Result>{next};
+    }
+
+    /**
+     * Run callback inline on the completing thread, for cheap bookkeeping such as WhenAll
+     */
+    void OnReady(Task&& callback) {m_state->OnReady(std::move(callback), false);}
+
+    std::shared_ptr<FutureState<T>> const& State() const {return m_state;}
+
+private:
+    template <typename F, bool = std::is_void_v<T>>
+    struct ThenResult {using type = std::invoke_result_t<F&>;};
+    template <typename F>
+    struct ThenResult<F, false> {using type = std::invoke_result_t<F&, T>;};
+
+    std::shared_ptr<FutureState<T>> m_state;
+};
+
+/**
+ * A future for all of futures, holding their results in order. The first exception wins. The result runs its
+ * continuations on the first future's executor; with no futures that is executor, and if that has no pool either
+ * the (already ready) result runs them inline.
+ */
+template <typename T>
+Future<std::vector<T>> WhenAll(std::vector<Future<T>> futures, Executor executor = {})
+{
+    if (!futures.empty())
+    {
+        executor = futures.front().State()->GetExecutor();
+    }
+
+    struct Join
+    {
+        Join(size_t count, Executor executor) : m_results(count), m_remaining{count}, m_promise{executor} {}
+        std::vector<std::optional<T>> m_results;
+        std::atomic<size_t> m_remaining;
+        std::atomic<bool> m_failed{false};
+        Promise<std::vector<T>> m_promise;
+    };
+
+    auto join = std::make_shared<Join>(futures.size(), executor);
+    auto result = join->m_promise.GetFuture();
+    if (futures.empty())
+    {
+        join->m_promise.SetValue({});
+        return result;
+    }
+
+    for (auto idx=0U; idx < futures.size(); ++idx)
+    {
+        auto state = futures[idx].State();
+        futures[idx].OnReady([join, state, idx]{
+            if (state->Error())
+            {
+                if (!join->m_failed.exchange(true))
+                {
+                    join->m_promise.SetError(state->Error());
+                }
+            }
+            else
+            {
+                join->m_results[idx].emplace(state->Take());
+            }
+            if (--join->m_remaining == 0 && !join->m_failed)
+            {
+                std::vector<T> values;
+                values.reserve(join->m_results.size());
+                for (auto& cur: join->m_results)
+                {
+                    values.push_back(std::move(*cur));
+                }
+                join->m_promise.SetValue(std::move(values));
+            }
+        });
+    }
+    return result;
+}
+
+/**
+ * A future that is ready once all of futures are. The first exception wins. Executors as for the WhenAll above.
+ */
+inline Future<void> WhenAll(std::vector<Future<void>> futures, Executor executor = {})
+{
+    if (!futures.empty())
+    {
+        executor = futures.front().State()->GetExecutor();
+    }
+
+    struct Join
+    {
+        Join(size_t count, Executor executor) : m_remaining{count}, m_promise{executor} {}
+        std::atomic<size_t> m_remaining;
+        std::atomic<bool> m_failed{false};
+        Promise<void> m_promise;
+    };
+
+    auto join = std::make_shared<Join>(futures.size(), executor);
+    auto result = join->m_promise.GetFuture();
+    if (futures.empty())
+    {
+        join->m_promise.SetValue();
+        return result;
+    }
+
+    for (auto& cur: futures)
+    {
+        auto state = cur.State();
+        cur.OnReady([join, state]{
+            if (state->Error() && !join->m_failed.exchange(true))
+            {
+                join->m_promise.SetError(state->Error());
+            }
+            if (--join->m_remaining == 0 && !join->m_failed)
+            {
+                join->m_promise.SetValue();
+            }
+        });
+    }
+    return result;
+}
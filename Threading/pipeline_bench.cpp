@@ -0,0 +1,258 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <stdexcept>
+#include <cstdint>
+
+#include "thread_pool.h"
+#include "future.h"
+#include "task_graph.h"
+#include "primality.h"
+#include "factor.h"
+#include "bench.h"
+#include "pool_workloads.h"
+
+/**
+ * Checks the futures and TaskGraph (ordering, exceptions, empty WhenAll, cycles), then times a two stage prime
+ * workload three ways: a ParallelFor barrier between the stages, a Then per block, and a TaskGraph node per block
+ * and stage. Stage one finds the primes in a block, stage two factors p - 1 for each of them and counts the factors.
+ */
+
+/**
+ * What one block of the workload produces: the primes in it and the prime factors of p - 1 over all of them
+ */
+struct BlockResult
+{
+    uint64_t m_primes{0};
+    uint64_t m_factors{0};
+
+    bool operator==(BlockResult const& rhs) const {return m_primes == rhs.m_primes && m_factors == rhs.m_factors;}
+};
+
+std::vector<uint64_t> PrimesIn(uint64_t lo, uint64_t hi)
+{
+    std::vector<uint64_t> primes;
+    for (auto value=lo; value < hi; ++value)
+    {
+        if (Primality::IsPrime(value))
+        {
+            primes.push_back(value);
+        }
+    }
+    return primes;
+}
+
+BlockResult FactorPredecessors(std::vector<uint64_t> const& primes)
+{
+    BlockResult result{primes.size(), 0};
+    for (auto prime: primes)
+    {
+        for (auto& [factor, exponent]: Factorizer::Factor(prime - 1))
+        {
+            result.m_factors += exponent;
+        }
+    }
+    return result;
+}
+
+BlockResult Sum(std::vector<BlockResult> const& blocks)
+{
+    BlockResult total;
+    for (auto const& block: blocks)
+    {
+        total.m_primes += block.m_primes;
+        total.m_factors += block.m_factors;
+    }
+    return total;
+}
+
+void CheckFutures(BenchSuite& suite, ThreadPool& pool)
+{
+    //Then runs in order, each step seeing the one before
+    std::vector<int> steps;
+    auto chained = pool.AddWork(useFuture, [&]{steps.push_back(1); return 1;})
+                       .Then([&](int value){steps.push_back(2); return value + 1;})
+                       .Then([&](int value){steps.push_back(3); return value * 10;})
+                       .Get();
+    suite.Check(chained == 20 && steps == std::vector<int>{1, 2, 3}, "Then chain runs in order");
+
+    //WhenAll keeps the order of its futures, not the order they complete in
+    std::vector<Promise<int>> promises;
+    std::vector<Future<int>> futures;
+    for (auto idx=0; idx < 100; ++idx)
+    {
+        promises.emplace_back(Executor{pool});
+        futures.push_back(promises.back().GetFuture());
+    }
+    auto all = WhenAll(std::move(futures));
+    for (auto idx=100; idx-- > 0; )
+    {
+        promises[idx].SetValue(idx);
+    }
+    auto values = all.Get();
+    bool inOrder = values.size() == 100;
+    for (auto idx=0U; inOrder && idx < values.size(); ++idx)
+    {
+        inOrder = values[idx] == static_cast<int>(idx);
+    }
+    suite.Check(inOrder, "WhenAll results in the order of the futures");
+
+    //an exception skips the rest of the chain, and fails a WhenAll
+    bool skipped{true};
+    bool threw{false};
+    try
+    {
+        pool.AddWork(useFuture, []() -> int {throw std::runtime_error("stage failed");})
+            .Then([&](int value){skipped = false; return value;})
+            .Get();
+    }
+    catch (std::runtime_error const&)
+    {
+        threw = true;
+    }
+    suite.Check(threw && skipped, "an exception passes through Then");
+    std::vector<Future<void>> mixed;
+    mixed.push_back(pool.AddWork(useFuture, []{}));
+    mixed.push_back(pool.AddWork(useFuture, []{throw std::runtime_error("one of many");}));
+    threw = false;
+    try
+    {
+        WhenAll(std::move(mixed)).Get();
+    }
+    catch (std::runtime_error const&)
+    {
+        threw = true;
+    }
+    suite.Check(threw, "an exception fails WhenAll");
+
+    //WhenAll of nothing is ready at once, and without an executor its continuations run inline
+    bool ran{false};
+    WhenAll(std::vector<Future<void>>{}).Then([&]{ran = true;}).Get();
+    auto none = WhenAll(std::vector<Future<int>>{}).Then([](std::vector<int> const& values){return values.size();}).Get();
+    auto onPool = WhenAll(std::vector<Future<int>>{}, Executor{pool}).Then([](std::vector<int> const& values){return values.size();}).Get();
+    suite.Check(ran && none == 0 && onPool == 0, "WhenAll of no futures");
+
+    //a diamond: every node starts after its dependencies finished, and a throwing node doesn't stop the rest
+    std::atomic<int> clock{0};
+    std::vector<int> finished(4, -1);
+    TaskGraph graph;
+    auto load = graph.Add([&]{finished[0] = clock++;});
+    auto left = graph.Add([&]{finished[1] = clock++;}, {load});
+    auto right = graph.Add([&]{finished[2] = clock++;}, {load});
+    graph.Add([&]{finished[3] = clock++;}, {left, right});
+    graph.Run(pool).Get();
+    suite.Check(finished[0] < finished[1] && finished[0] < finished[2] && finished[1] < finished[3] && finished[2] < finished[3],
+                "TaskGraph runs nodes after their dependencies");
+
+    TaskGraph failing;
+    std::atomic<bool> after{false};
+    auto thrower = failing.Add([]{throw std::runtime_error("node failed");});
+    failing.Add([&]{after = true;}, {thrower});
+    threw = false;
+    try
+    {
+        failing.Run(pool).Get();
+    }
+    catch (std::runtime_error const&)
+    {
+        threw = true;
+    }
+    suite.Check(threw && after, "a throwing TaskGraph node fails the run, the rest still runs");
+
+    //a cycle, and a node that doesn't exist
+    TaskGraph cyclic;
+    auto first = cyclic.Add([]{});
+    auto second = cyclic.Add([]{}, {first});
+    cyclic.Precede(second, first);
+    threw = false;
+    try
+    {
+        cyclic.Run(pool).Get();
+    }
+    catch (std::logic_error const&)
+    {
+        threw = true;
+    }
+    suite.Check(threw, "TaskGraph rejects a cycle");
+    threw = false;
+    try
+    {
+        cyclic.Precede(first, 7);
+    }
+    catch (std::out_of_range const&)
+    {
+        threw = true;
+    }
+    suite.Check(threw, "TaskGraph rejects a node that doesn't exist");
+}
+
+/**
+ * Takes the highest thread count (default one per hardware thread), the limit of the workload (default 2 * 10^6)
+ * and the number of blocks (default 256), and the options in bench.h
+ */
+int main(int argc, char* argv[])
+{
+    BenchSuite suite{"pipeline", argc, argv};
+    size_t maxThreads = suite.Arg(0, std::max(1U, std::thread::hardware_concurrency()));
+    uint64_t limit = suite.Arg(1, 2000000);
+    size_t blocks = std::max<size_t>(suite.Arg(2, 256), 1);
+
+    {
+        ThreadPool pool{std::min<size_t>(maxThreads, 4)};
+        pool.Start();
+        CheckFutures(suite, pool);
+        pool.Stop();
+    }
+
+    auto blockLo = [&](size_t block) {return 1 + block * limit / blocks;};
+    auto expected = FactorPredecessors(PrimesIn(1, limit + 1));
+    for (auto threads: ThreadCounts(maxThreads))
+    {
+        ThreadPool pool{threads};
+        pool.Start();
+        auto suffix = "/threads" + std::to_string(threads);
+        BlockResult total;
+
+        //both stages over every block, with a barrier in between
+        suite.Run("barrier" + suffix, [&]{
+            std::vector<std::vector<uint64_t>> primes(blocks);
+            std::vector<BlockResult> results(blocks);
+            pool.ParallelFor(0, blocks, 1, [&](size_t block) {primes[block] = PrimesIn(blockLo(block), blockLo(block + 1));});
+            pool.ParallelFor(0, blocks, 1, [&](size_t block) {results[block] = FactorPredecessors(primes[block]);});
+            total = Sum(results);
+        }, limit);
+        suite.Check(total == expected, "barrier" + suffix);
+
+        //each block's second stage chained to its first
+        suite.Run("futures" + suffix, [&]{
+            std::vector<Future<BlockResult>> results;
+            for (auto block=0U; block < blocks; ++block)
+            {
+                results.push_back(pool.AddWork(useFuture, [&, block]{return PrimesIn(blockLo(block), blockLo(block + 1));})
+                                      .Then([](std::vector<uint64_t> primes){return FactorPredecessors(primes);}));
+            }
+            total = WhenAll(std::move(results)).Then([](std::vector<BlockResult> blocks){return Sum(blocks);}).Get();
+        }, limit);
+        suite.Check(total == expected, "futures" + suffix);
+
+        //the same as a graph, built once and run every rep
+        std::vector<std::vector<uint64_t>> primes(blocks);
+        std::vector<BlockResult> results(blocks);
+        TaskGraph graph;
+        for (auto block=0U; block < blocks; ++block)
+        {
+            auto find = graph.Add([&, block]{primes[block] = PrimesIn(blockLo(block), blockLo(block + 1));});
+            graph.Add([&, block]{results[block] = FactorPredecessors(primes[block]);}, {find});
+        }
+        suite.Run("graph" + suffix, [&]{
+            graph.Run(pool).Get();
+            total = Sum(results);
+        }, limit);
+        suite.Check(total == expected, "graph" + suffix);
+        pool.Stop();
+    }
+    return suite.Finish();
+}
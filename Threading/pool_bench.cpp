@@ -0,0 +1,145 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <new>
+#include <cstdlib>
+
+#include "thread_pool.h"
+#include "bench.h"
+#include "pool_workloads.h"
+
+/**
+ * Times the ThreadPool, in both scheduling modes, at 1, 2, 4, ... threads (see pool_workloads.h, which the
+ * Atomics pool is measured with too)
+ */
+
+/**
+ * Every allocation in the program, so the check below can see what queueing work costs
+ */
+std::atomic<size_t> g_allocations{0};
+
+void* operator new(size_t size)
+{
+    ++g_allocations;
+    if (auto memory = std::malloc(size == 0 ? 1 : size))
+    {
+        return memory;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+void CountTask(std::atomic<size_t>& ran, size_t)
+{
+    ++ran;
+}
+
+/**
+ * Queueing a lambda or a std::bind allocates nothing but the queues' slabs as they grow (a few dozen times for
+ * any number of tasks). The pool is filled before it starts, so nothing is taken off while counting.
+ */
+void CheckAddWorkAllocations(BenchSuite& suite, size_t tasks)
+{
+    for (auto [name, scheduling]: {std::pair{"stealing", ThreadPool::Scheduling::WorkStealing},
+                                   std::pair{"shared", ThreadPool::Scheduling::SharedQueue}})
+    {
+        ThreadPool pool{2, scheduling};
+        std::atomic<size_t> ran{0};
+        auto before = g_allocations.load();
+        for (auto idx=0U; idx < tasks; ++idx)
+        {
+            if (idx % 2 == 0)
+            {
+                pool.AddWork([&ran]{++ran;});
+            }
+            else
+            {
+                pool.AddWork(std::bind(&CountTask, std::ref(ran), idx));
+            }
+        }
+        auto allocations = g_allocations - before;
+        pool.Start();
+        pool.Stop();
+        std::cout << name << ": " << allocations << " allocations queueing " << tasks << " tasks" << std::endl;
+        suite.Check(allocations <= 64 && ran == tasks, std::string{"AddWork allocates only for slab growth, "} + name);
+    }
+}
+
+/**
+ * Where PlaceWorkers puts 8 workers under each policy, on a made up box of two nodes with two 2-way SMT cores each
+ * (CPUs 0-3 on node 0, 4-7 on node 1, 0 and 1 sharing a core)
+ */
+void CheckPlacement(BenchSuite& suite)
+{
+    auto topology = CpuTopology::FromDescription("0-3@2;4-7@2");
+    auto cpusOf = [&](PlacementPolicy::Kind kind, std::vector<unsigned> explicitCpus = {}) {
+        std::vector<std::vector<unsigned>> cpus;
+        std::vector<unsigned> nodes;
+        for (auto& cur: PlaceWorkers(PlacementPolicy{kind, topology, explicitCpus}, 8))
+        {
+            cpus.push_back(cur.m_cpus);
+            nodes.push_back(cur.m_node);
+        }
+        return std::pair{cpus, nodes};
+    };
+    using Cpus = std::vector<std::vector<unsigned>>;
+    using Nodes = std::vector<unsigned>;
+
+    suite.Check(cpusOf(PlacementPolicy::Kind::None) == std::pair{Cpus(8), Nodes(8, 0)}, "None placement leaves workers unpinned");
+    suite.Check(cpusOf(PlacementPolicy::Kind::Compact) ==
+                    std::pair{Cpus{{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}}, Nodes{0, 0, 0, 0, 1, 1, 1, 1}},
+                "Compact placement fills a core, then a node");
+    suite.Check(cpusOf(PlacementPolicy::Kind::Scatter) ==
+                    std::pair{Cpus{{0}, {4}, {2}, {6}, {1}, {5}, {3}, {7}}, Nodes{0, 1, 0, 1, 0, 1, 0, 1}},
+                "Scatter placement alternates nodes, physical cores before siblings");
+    Cpus perNode;
+    for (auto worker=0U; worker < 8; ++worker)
+    {
+        perNode.push_back(worker % 2 == 0 ? std::vector<unsigned>{0, 1, 2, 3} : std::vector<unsigned>{4, 5, 6, 7});
+    }
+    suite.Check(cpusOf(PlacementPolicy::Kind::PerNode) == std::pair{perNode, Nodes{0, 1, 0, 1, 0, 1, 0, 1}},
+                "PerNode placement gives each worker a whole node");
+    suite.Check(cpusOf(PlacementPolicy::Kind::Explicit, {5, 2}) ==
+                    std::pair{Cpus{{5}, {2}, {5}, {2}, {5}, {2}, {5}, {2}}, Nodes{1, 0, 1, 0, 1, 0, 1, 0}},
+                "Explicit placement cycles through the CPUs given");
+}
+
+/**
+ * Takes the highest thread count (default one per hardware thread), the number of tasks (default 10^5) and the
+ * prime limit (default 2 * 10^6), and the options in bench.h
+ */
+int main(int argc, char* argv[])
+{
+    BenchSuite suite{"thread_pool", argc, argv};
+    size_t maxThreads = suite.Arg(0, std::max(1U, std::thread::hardware_concurrency()));
+    size_t tasks = suite.Arg(1, 100000);
+    uint64_t primeLimit = suite.Arg(2, 2000000);
+
+    CheckAddWorkAllocations(suite, tasks);
+    CheckPlacement(suite);
+
+    for (auto [name, scheduling]: {std::pair{"stealing", ThreadPool::Scheduling::WorkStealing},
+                                   std::pair{"shared", ThreadPool::Scheduling::SharedQueue}})
+    {
+        for (auto threads: ThreadCounts(maxThreads))
+        {
+            ThreadPool pool{threads, scheduling};
+            pool.Start();
+            BenchPool(suite, std::string{"threading/"} + name, pool, threads, tasks, primeLimit);
+            pool.Stop();
+        }
+    }
+    return suite.Finish();
+}
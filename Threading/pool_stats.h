@@ -0,0 +1,321 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <array>
+#include <vector>
+#include <chrono>
+#include <ostream>
+#include <iomanip>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "priority.h"
+
+/**
+ * Pool telemetry. Every worker owns a WorkerCounters (on its own cache line) and is the only thread that
+ * normally touches it, so recording a task costs a handful of uncontended relaxed adds and two cycle counter
+ * reads. Stats() snapshots are taken on demand and never stop the workers.
+ */
+
+/**
+ * The cheapest monotonic clock we have: the TSC on x86 (invariant on anything recent), steady_clock elsewhere.
+ * Ticks are converted to nanoseconds only when a snapshot is taken.
+ */
+inline uint64_t ReadTicks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * Measures ticks per nanosecond over the lifetime of the object, so no start-up calibration loop is needed
+ */
+class TickCalibration
+{
+public:
+    TickCalibration() : m_ticks{ReadTicks()}, m_start{std::chrono::steady_clock::now()} {}
+
+    double NsPerTick() const
+    {
+        auto ticks = ReadTicks() - m_ticks;
+        auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - m_start).count();
+        return ticks == 0 ? 1.0 : ns / ticks;
+    }
+
+private:
+    uint64_t m_ticks;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+/**
+ * A counter for one (mostly) single writer
+ */
+class StatCounter
+{
+public:
+    void Add(uint64_t value) {m_value.fetch_add(value, std::memory_order_relaxed);}
+    uint64_t Get() const {return m_value.load(std::memory_order_relaxed);}
+
+private:
+    std::atomic<uint64_t> m_value{0};
+};
+
+/**
+ * Raise max to value if it is bigger
+ */
+inline void UpdateMax(std::atomic<size_t>& max, size_t value)
+{
+    auto cur = max.load(std::memory_order_relaxed);
+    while (value > cur && !max.compare_exchange_weak(cur, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+/**
+ * Bucket i counts durations of [2^(i-1), 2^i) ticks, bucket 0 counts zero
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr size_t Buckets{48};
+
+    void Record(uint64_t ticks)
+    {
+        size_t bucket = ticks == 0 ? 0 : 64 - __builtin_clzll(ticks);
+        m_counts[bucket < Buckets ? bucket : Buckets - 1].Add(1);
+    }
+
+    uint64_t Count(size_t bucket) const {return m_counts[bucket].Get();}
+
+private:
+    std::array<StatCounter, Buckets> m_counts;
+};
+
+/**
+ * A point in time copy of a LatencyHistogram, in nanoseconds
+ */
+struct HistogramSnapshot
+{
+    std::array<uint64_t, LatencyHistogram::Buckets> m_counts{};
+    double m_nsPerTick{1.0};
+
+    void Add(LatencyHistogram const& hist)
+    {
+        for (auto bucket=0U; bucket < LatencyHistogram::Buckets; ++bucket)
+        {
+            m_counts[bucket] += hist.Count(bucket);
+        }
+    }
+
+    void Add(HistogramSnapshot const& other)
+    {
+        for (auto bucket=0U; bucket < LatencyHistogram::Buckets; ++bucket)
+        {
+            m_counts[bucket] += other.m_counts[bucket];
+        }
+    }
+
+    uint64_t Count() const
+    {
+        uint64_t total{0};
+        for (auto cur: m_counts)
+        {
+            total += cur;
+        }
+        return total;
+    }
+
+    /**
+     * Upper bound of the bucket holding the given fraction (0.5 for the median) of the samples, 0 if empty
+     */
+    double PercentileNs(double fraction) const
+    {
+        auto total = Count();
+        if (total == 0)
+        {
+            return 0.0;
+        }
+        auto target = static_cast<uint64_t>(fraction * (total - 1)) + 1;
+        uint64_t seen{0};
+        for (auto bucket=0U; bucket < LatencyHistogram::Buckets; ++bucket)
+        {
+            seen += m_counts[bucket];
+            if (seen >= target)
+            {
+                return bucket == 0 ? 0.0 : static_cast<double>(1ULL << bucket) * m_nsPerTick;
+            }
+        }
+        return static_cast<double>(1ULL << (LatencyHistogram::Buckets - 1)) * m_nsPerTick;
+    }
+};
+
+/**
+ * Live counters for one worker (or for all threads outside the pool that run pool work)
+ */
+struct alignas(64) WorkerCounters
+{
+    StatCounter m_tasks; //tasks executed
+    StatCounter m_steals; //tasks taken from another worker's queue
+    StatCounter m_idleTicks; //time spent with nothing to do (spinning or parked)
+    StatCounter m_lockAcquisitions; //locks taken
+    StatCounter m_lockSpins; //spins (or failed try_locks) before getting them
+    std::array<LatencyHistogram, PriorityLanes> m_wait; //enqueue to start, per priority lane
+    LatencyHistogram m_run; //start to finish
+};
+
+/**
+ * The counters of whichever pool worker is running on this thread, so locks used by pool work can report to it
+ */
+inline thread_local WorkerCounters* t_workerCounters{nullptr};
+
+/**
+ * Record one lock acquisition that needed spins extra attempts against the current worker, if any
+ */
+inline void RecordLock(uint64_t spins)
+{
+    if (auto counters = t_workerCounters)
+    {
+        counters->m_lockAcquisitions.Add(1);
+        counters->m_lockSpins.Add(spins);
+    }
+}
+
+/**
+ * Lock mutex, counting it as contended if it wasn't free
+ */
+template <typename Mutex>
+std::unique_lock<Mutex> LockCounted(Mutex& mutex, WorkerCounters& counters)
+{
+    std::unique_lock<Mutex> guard{mutex, std::try_to_lock};
+    counters.m_lockAcquisitions.Add(1);
+    if (!guard.owns_lock())
+    {
+        counters.m_lockSpins.Add(1);
+        guard.lock();
+    }
+    return guard;
+}
+
+/**
+ * A point in time copy of a WorkerCounters
+ */
+struct WorkerStats
+{
+    uint64_t m_tasks{0};
+    uint64_t m_steals{0};
+    double m_idleNs{0};
+    uint64_t m_lockAcquisitions{0};
+    uint64_t m_lockSpins{0};
+    HistogramSnapshot m_wait; //all lanes
+    std::array<HistogramSnapshot, PriorityLanes> m_laneWait;
+    HistogramSnapshot m_run;
+
+    WorkerStats() = default;
+    WorkerStats(WorkerCounters const& counters, double nsPerTick)
+        : m_tasks{counters.m_tasks.Get()}
+        , m_steals{counters.m_steals.Get()}
+        , m_idleNs{counters.m_idleTicks.Get() * nsPerTick}
+        , m_lockAcquisitions{counters.m_lockAcquisitions.Get()}
+        , m_lockSpins{counters.m_lockSpins.Get()}
+    {
+        m_wait.m_nsPerTick = nsPerTick;
+        for (auto lane=0U; lane < PriorityLanes; ++lane)
+        {
+            m_laneWait[lane].m_nsPerTick = nsPerTick;
+            m_laneWait[lane].Add(counters.m_wait[lane]);
+            m_wait.Add(m_laneWait[lane]);
+        }
+        m_run.m_nsPerTick = nsPerTick;
+        m_run.Add(counters.m_run);
+    }
+
+    void Add(WorkerStats const& other)
+    {
+        m_tasks += other.m_tasks;
+        m_steals += other.m_steals;
+        m_idleNs += other.m_idleNs;
+        m_lockAcquisitions += other.m_lockAcquisitions;
+        m_lockSpins += other.m_lockSpins;
+        m_wait.m_nsPerTick = other.m_wait.m_nsPerTick;
+        m_wait.Add(other.m_wait);
+        for (auto lane=0U; lane < PriorityLanes; ++lane)
+        {
+            m_laneWait[lane].m_nsPerTick = other.m_laneWait[lane].m_nsPerTick;
+            m_laneWait[lane].Add(other.m_laneWait[lane]);
+        }
+        m_run.m_nsPerTick = other.m_run.m_nsPerTick;
+        m_run.Add(other.m_run);
+    }
+};
+
+/**
+ * What ThreadPool::Stats() returns
+ */
+struct PoolStats
+{
+    std::vector<WorkerStats> m_workers; //one per worker thread
+    WorkerStats m_external; //pool work run by threads outside the pool (e.g. while waiting in ParallelFor)
+    size_t m_queueDepth{0}; //queued when the snapshot was taken
+    size_t m_queueHighWater{0}; //deepest the queue has been
+
+    WorkerStats Total() const
+    {
+        WorkerStats total{m_external};
+        for (auto& cur: m_workers)
+        {
+            total.Add(cur);
+        }
+        return total;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& os, PoolStats const& stats)
+{
+    //the rows set fixed and the precision, give the caller's stream back as it was
+    auto flags = os.flags();
+    auto precision = os.precision();
+    auto row = [&](auto const& name, WorkerStats const& cur) {
+        os << std::setw(8) << name
+           << std::setw(12) << cur.m_tasks
+           << std::setw(10) << cur.m_steals
+           << std::setw(12) << std::fixed << std::setprecision(1) << cur.m_idleNs / 1e6
+           << std::setw(12) << cur.m_lockAcquisitions
+           << std::setw(10) << cur.m_lockSpins
+           << std::setw(12) << std::setprecision(0) << cur.m_wait.PercentileNs(0.5)
+           << std::setw(12) << cur.m_wait.PercentileNs(0.99)
+           << std::setw(12) << cur.m_run.PercentileNs(0.5)
+           << std::setw(12) << cur.m_run.PercentileNs(0.99) << std::endl;
+    };
+
+    os << "Queue depth " << stats.m_queueDepth << " (high water " << stats.m_queueHighWater << ")" << std::endl;
+    os << std::setw(8) << "worker" << std::setw(12) << "tasks" << std::setw(10) << "steals" << std::setw(12) << "idle ms"
+       << std::setw(12) << "locks" << std::setw(10) << "spins" << std::setw(12) << "wait p50ns" << std::setw(12) << "wait p99ns"
+       << std::setw(12) << "run p50ns" << std::setw(12) << "run p99ns" << std::endl;
+    for (auto idx=0U; idx < stats.m_workers.size(); ++idx)
+    {
+        row(idx, stats.m_workers[idx]);
+    }
+    row("extern", stats.m_external);
+    auto total = stats.Total();
+    row("total", total);
+
+    os << std::setw(8) << "lane" << std::setw(12) << "tasks" << std::setw(12) << "wait p50ns" << std::setw(12) << "wait p99ns" << std::endl;
+    for (auto lane=0U; lane < PriorityLanes; ++lane)
+    {
+        auto const& wait = total.m_laneWait[lane];
+        os << std::setw(8) << LaneName(lane)
+           << std::setw(12) << wait.Count()
+           << std::setw(12) << std::fixed << std::setprecision(0) << wait.PercentileNs(0.5)
+           << std::setw(12) << wait.PercentileNs(0.99) << std::endl;
+    }
+    os.flags(flags);
+    os.precision(precision);
+    return os;
+}
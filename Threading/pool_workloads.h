@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <string>
+#include <thread>
+#include <cstdint>
+
+#include "bench.h"
+#include "primality.h"
+
+/**
+ * The workloads both ThreadPools (this one and the one in Atomics) are benchmarked with, so their numbers line up.
+ * Pool needs Start, Stop, AddWork, ParallelFor and RunOne.
+ */
+
+/**
+ * 1, 2, 4, ... up to maxThreads, always including maxThreads
+ */
+inline std::vector<size_t> ThreadCounts(size_t maxThreads)
+{
+    std::vector<size_t> counts;
+    for (size_t threads=1; threads < maxThreads; threads *= 2)
+    {
+        counts.push_back(threads);
+    }
+    counts.push_back(maxThreads);
+    return counts;
+}
+
+/**
+ * Run every workload on pool, naming the cases prefix/<workload>/threads<threads>
+ */
+template <typename Pool>
+void BenchPool(BenchSuite& suite, std::string const& prefix, Pool& pool, size_t threads, size_t tasks, uint64_t primeLimit)
+{
+    auto suffix = "/threads" + std::to_string(threads);
+
+    //queueing cost: tiny independent tasks, drained by the workers and the submitting thread
+    suite.Run(prefix + "/tasks" + suffix, [&]{
+        std::atomic<size_t> remaining{tasks};
+        for (auto idx=0U; idx < tasks; ++idx)
+        {
+            pool.AddWork([&remaining]{remaining.fetch_sub(1, std::memory_order_relaxed);});
+        }
+        while (remaining.load() != 0)
+        {
+            if (!pool.RunOne())
+            {
+                std::this_thread::yield();
+            }
+        }
+    }, tasks);
+
+    //chunking cost: a range with next to nothing to do per index
+    suite.Run(prefix + "/parallel_for" + suffix, [&]{
+        pool.ParallelFor(0, tasks * 10, 0, [](size_t idx){DoNotOptimize(idx);});
+    }, tasks * 10);
+
+    //real work: test every number up to primeLimit
+    std::vector<uint8_t> isPrime(primeLimit + 1);
+    suite.Run(prefix + "/isprime" + suffix, [&]{
+        pool.ParallelFor(1, primeLimit + 1, 0, [&](size_t value){isPrime[value] = Primality::IsPrime(value);});
+    }, primeLimit);
+}
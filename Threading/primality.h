@@ -0,0 +1,162 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/**
+ * Arithmetic mod an odd n in Montgomery form: values are kept as a * R mod n (R = 2^bits of UInt), which turns every
+ * modular multiplication into two plain multiplications and a shift instead of a division. Wide must hold two
+ * UInts.
+ */
+template <typename UInt, typename Wide>
+class Montgomery
+{
+public:
+    static constexpr unsigned Bits{sizeof(UInt) * 8};
+
+    explicit Montgomery(UInt n) : m_n{n}, m_inv{Inverse(n)}
+    {
+        UInt r = static_cast<UInt>(0 - n) % n; //R mod n
+        m_r2 = static_cast<UInt>(static_cast<Wide>(r) * r % n);
+        m_one = r;
+        m_minusOne = n - r;
+    }
+
+    UInt ToMont(UInt value) const {return Multiply(value % m_n, m_r2);}
+    UInt FromMont(UInt value) const {return Reduce(value);}
+    UInt One() const {return m_one;}
+    UInt MinusOne() const {return m_minusOne;}
+
+    UInt Multiply(UInt lhs, UInt rhs) const
+    {
+        return Reduce(static_cast<Wide>(lhs) * rhs);
+    }
+
+    UInt Power(UInt base, UInt exponent) const
+    {
+        UInt result = m_one;
+        while (exponent != 0)
+        {
+            if (exponent & 1)
+            {
+                result = Multiply(result, base);
+            }
+            base = Multiply(base, base);
+            exponent >>= 1;
+        }
+        return result;
+    }
+
+private:
+    /**
+     * n^-1 mod R by Newton's iteration, every step doubles the correct low bits
+     */
+    static UInt Inverse(UInt n)
+    {
+        UInt inv = n; //correct to 3 bits for any odd n
+        for (auto bits=3U; bits < Bits; bits *= 2)
+        {
+            inv *= 2 - n * inv;
+        }
+        return inv;
+    }
+
+    /**
+     * value * R^-1 mod n, for value < n * R
+     */
+    UInt Reduce(Wide value) const
+    {
+        UInt m = static_cast<UInt>(value) * m_inv; //m * n has the same low half as value
+        UInt high = static_cast<UInt>(value >> Bits);
+        UInt mn = static_cast<UInt>((static_cast<Wide>(m) * m_n) >> Bits);
+        return high >= mn ? high - mn : high - mn + m_n;
+    }
+
+    UInt m_n;
+    UInt m_inv;
+    UInt m_r2{0};
+    UInt m_one{0};
+    UInt m_minusOne{0};
+};
+
+/**
+ * Deterministic primality testing for any 64 bit number: trial division by the primes below 60, then a strong
+ * probable prime (Miller-Rabin) test to the witness sets known to have no counterexamples, {2, 7, 61} below 2^32
+ * and Jim Sinclair's seven bases above.
+ */
+class Primality
+{
+public:
+    static constexpr std::array<uint32_t, 16> SmallPrimes{2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53};
+    static constexpr std::array<uint64_t, 3> Witnesses32{2, 7, 61};
+    static constexpr std::array<uint64_t, 7> Witnesses64{2, 325, 9375, 28178, 450775, 9780504, 1795265022};
+
+    static bool IsPrime(uint64_t value)
+    {
+        if (value < 2)
+        {
+            return false;
+        }
+        for (auto prime: SmallPrimes)
+        {
+            if (value % prime == 0)
+            {
+                return value == prime;
+            }
+        }
+        if (value < 59 * 59)
+        {
+            return true;
+        }
+
+        if (value <= UINT32_MAX)
+        {
+            return StrongProbablePrime(Montgomery<uint32_t, uint64_t>{static_cast<uint32_t>(value)},
+                                       static_cast<uint32_t>(value), Witnesses32);
+        }
+        return StrongProbablePrime(Montgomery<uint64_t, unsigned __int128>{value}, value, Witnesses64);
+    }
+
+private:
+    template <typename UInt, typename Wide, size_t Count>
+    static bool StrongProbablePrime(Montgomery<UInt, Wide> const& mont, UInt value, std::array<uint64_t, Count> const& witnesses)
+    {
+        //value - 1 = odd * 2^shift
+        UInt odd = value - 1;
+        unsigned shift{0};
+        while ((odd & 1) == 0)
+        {
+            odd >>= 1;
+            ++shift;
+        }
+
+        for (auto witness: witnesses)
+        {
+            auto base = static_cast<UInt>(witness % value);
+            if (base == 0)
+            {
+                continue; //a multiple of value says nothing
+            }
+            auto cur = mont.Power(mont.ToMont(base), odd);
+            if (cur == mont.One() || cur == mont.MinusOne())
+            {
+                continue;
+            }
+            bool passed{false};
+            for (auto round=1U; round < shift; ++round)
+            {
+                cur = mont.Multiply(cur, cur);
+                if (cur == mont.MinusOne())
+                {
+                    passed = true;
+                    break;
+                }
+            }
+            if (!passed)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
@@ -0,0 +1,167 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <string>
+#include <cstdint>
+
+#include "primality.h"
+#include "bench.h"
+#include "../sieve_simple/wheel_sieve.h"
+
+/**
+ * Cross-checks Primality::IsPrime, then measures how long it takes per candidate for 32 and 64 bit numbers
+ */
+
+/**
+ * The original FactorPrimes::IsPrime, for comparison
+ */
+bool TrialDivision(uint64_t val)
+{
+    if (val == 0 || val == 1)
+    {
+        return false;
+    }
+    for (uint64_t count=2; count <= val/2; ++count)
+    {
+        if (val % count == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Trial division up to sqrt(val), slow but obviously right
+ */
+bool TrialDivisionToRoot(uint64_t val)
+{
+    if (val < 2)
+    {
+        return false;
+    }
+    for (uint64_t count=2; count * count <= val; ++count)
+    {
+        if (val % count == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CrossCheck(uint64_t sieveLimit)
+{
+    //every number up to sieveLimit against the sieve
+    std::vector<bool> isPrime(sieveLimit + 1);
+    WheelSieve{sieveLimit}.ForEachPrime([&](uint64_t prime) {isPrime[prime] = true;});
+    for (uint64_t val=0; val <= sieveLimit; ++val)
+    {
+        if (Primality::IsPrime(val) != isPrime[val])
+        {
+            std::cout << "IsPrime(" << val << ") disagrees with the sieve" << std::endl;
+            return false;
+        }
+    }
+
+    //random numbers up to 2^40, where trial division is still affordable
+    std::mt19937_64 rng{42};
+    for (auto count=0; count < 20000; ++count)
+    {
+        auto val = rng() >> 24;
+        if (Primality::IsPrime(val) != TrialDivisionToRoot(val))
+        {
+            std::cout << "IsPrime(" << val << ") disagrees with trial division" << std::endl;
+            return false;
+        }
+    }
+
+    //numbers that fool weaker tests: Carmichael numbers, strong pseudoprimes to several bases, semiprimes with
+    //32 bit factors, and primes at the top of the range
+    std::vector<std::pair<uint64_t, bool>> known{
+        {561, false}, {41041, false}, {825265, false}, {321197185, false},
+        {3215031751ULL, false}, {4759123141ULL, false}, {1122004669633ULL, false}, {3825123056546413051ULL, false},
+        {4294967291ULL * 4294967279ULL, false}, {4294967311ULL * 4294967357ULL, false},
+        {4294967291ULL, true}, {4294967311ULL, true}, {2305843009213693951ULL, true},
+        {18446744073709551557ULL, true}, {18446744073709551615ULL, false}, {18446744073709551533ULL, true}};
+    for (auto& [val, prime]: known)
+    {
+        if (Primality::IsPrime(val) != prime)
+        {
+            std::cout << "IsPrime(" << val << ") should be " << std::boolalpha << prime << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename F>
+void Time(BenchSuite& suite, std::string const& name, std::vector<uint64_t> const& values, F&& test)
+{
+    suite.Run(name, [&]{
+        size_t primes{0};
+        for (auto val: values)
+        {
+            primes += test(val) ? 1 : 0;
+        }
+        DoNotOptimize(primes);
+    }, values.size());
+}
+
+/**
+ * Takes the limit for the sieve cross-check (default 10^7) and the number of candidates to time (default 10^6), and
+ * the options in bench.h
+ */
+int main(int argc, char* argv[])
+{
+    BenchSuite suite{"primality", argc, argv};
+    uint64_t sieveLimit = suite.Arg(0, 10000000);
+    size_t candidates = suite.Arg(1, 1000000);
+
+    if (!CrossCheck(sieveLimit))
+    {
+        return -1;
+    }
+    std::cout << "Cross-check passed up to " << sieveLimit << std::endl;
+
+    std::mt19937_64 rng{7};
+    auto make = [&](auto&& next) {
+        std::vector<uint64_t> values(candidates);
+        for (auto& val: values)
+        {
+            val = next();
+        }
+        return values;
+    };
+    auto nextPrime = [&](uint64_t val) {
+        while (!Primality::IsPrime(val))
+        {
+            ++val;
+        }
+        return val;
+    };
+
+    auto small = make([&]{return (rng() >> 44) | 1;});
+    auto odd32 = make([&]{return (rng() >> 32) | 1;});
+    auto odd64 = make([&]{return rng() | 1;});
+    std::vector<uint64_t> primes32(candidates / 10);
+    std::vector<uint64_t> primes64(candidates / 10);
+    for (auto& val: primes32)
+    {
+        val = nextPrime((rng() >> 33) | (1ULL << 31));
+    }
+    for (auto& val: primes64)
+    {
+        val = nextPrime(rng() | (1ULL << 63));
+    }
+
+    std::vector<uint64_t> fewSmall(small.begin(), small.begin() + std::min<size_t>(small.size(), 2000));
+    Time(suite, "isprime/20bit/val_2_division", fewSmall, TrialDivision);
+    Time(suite, "isprime/20bit", small, Primality::IsPrime);
+    Time(suite, "isprime/odd32", odd32, Primality::IsPrime);
+    Time(suite, "isprime/primes32", primes32, Primality::IsPrime);
+    Time(suite, "isprime/odd64", odd64, Primality::IsPrime);
+    Time(suite, "isprime/primes64", primes64, Primality::IsPrime);
+    return suite.Finish();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * The lane a piece of pool work is queued on. Workers serve the highest lane that has work, so an interactive
+ * request doesn't wait behind a bulk sweep queued before it. The pool keeps lower lanes from starving.
+ */
+enum class Priority
+{
+    High,
+    Normal,
+    Low
+};
+
+inline constexpr size_t PriorityLanes{3};
+
+inline constexpr size_t LaneOf(Priority priority)
+{
+    return static_cast<size_t>(priority);
+}
+
+inline char const* LaneName(size_t lane)
+{
+    static char const* const names[PriorityLanes]{"high", "normal", "low"};
+    return lane < PriorityLanes ? names[lane] : "?";
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+
+/**
+ * Collects values from many threads without a shared lock or shared cache line on the hot path. Every thread appends
+ * to a buffer of its own, found through a thread_local cache. A thread's first Add registers its buffer by pushing
+ * it on a lock-free list. Merge concatenates the buffers into one sorted, contiguous vector.
+ *
+ * Add may be called concurrently. Merge must not run alongside Add, call it once the producers are done (e.g. after
+ * ParallelFor returns).
+ */
+template <typename T>
+class ResultSink
+{
+public:
+    ResultSink() : m_id{NextId()} {}
+    ResultSink(ResultSink const&) = delete;
+    ~ResultSink()
+    {
+        auto buffer = m_head.load();
+        while (buffer)
+        {
+            auto next = buffer->m_next;
+            delete buffer;
+            buffer = next;
+        }
+    }
+
+    void Add(T value)
+    {
+        LocalBuffer().m_values.push_back(std::move(value));
+    }
+
+    /**
+     * All values added so far, sorted
+     */
+    std::vector<T> Merge() const
+    {
+        size_t total{0};
+        for (auto buffer = m_head.load(std::memory_order_acquire); buffer; buffer = buffer->m_next)
+        {
+            total += buffer->m_values.size();
+        }
+        std::vector<T> merged;
+        merged.reserve(total);
+        for (auto buffer = m_head.load(std::memory_order_acquire); buffer; buffer = buffer->m_next)
+        {
+            merged.insert(merged.end(), buffer->m_values.begin(), buffer->m_values.end());
+        }
+        std::sort(merged.begin(), merged.end());
+        return merged;
+    }
+
+    size_t Size() const
+    {
+        size_t total{0};
+        for (auto buffer = m_head.load(std::memory_order_acquire); buffer; buffer = buffer->m_next)
+        {
+            total += buffer->m_values.size();
+        }
+        return total;
+    }
+
+private:
+    /**
+     * One thread's values, on its own cache line
+     */
+    struct alignas(64) Buffer
+    {
+        std::thread::id m_owner;
+        std::vector<T> m_values;
+        Buffer* m_next{nullptr};
+    };
+
+    /**
+     * The last sink this thread added to and its buffer there
+     */
+    struct Cache
+    {
+        uint64_t m_sink{0};
+        Buffer* m_buffer{nullptr};
+    };
+
+    static uint64_t NextId()
+    {
+        static std::atomic<uint64_t> nextId{1};
+        return nextId++;
+    }
+
+    Buffer& LocalBuffer()
+    {
+        if (t_cache.m_sink == m_id)
+        {
+            return *t_cache.m_buffer;
+        }
+
+        //switched sinks, or first time here: find our buffer, or register a new one
+        auto self = std::this_thread::get_id();
+        auto buffer = m_head.load(std::memory_order_acquire);
+        while (buffer && buffer->m_owner != self)
+        {
+            buffer = buffer->m_next;
+        }
+        if (!buffer)
+        {
+            buffer = new Buffer;
+            buffer->m_owner = self;
+            buffer->m_next = m_head.load(std::memory_order_relaxed);
+            while (!m_head.compare_exchange_weak(buffer->m_next, buffer, std::memory_order_release, std::memory_order_relaxed))
+            {
+            }
+        }
+        t_cache = Cache{m_id, buffer};
+        return *buffer;
+    }
+
+    uint64_t m_id; //never reused, so a stale t_cache can't match a new sink at the same address
+    std::atomic<Buffer*> m_head{nullptr};
+
+    inline static thread_local Cache t_cache;
+};
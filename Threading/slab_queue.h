@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+/**
+ * A double ended queue of move-only values kept in one contiguous, power of two sized ring.
+ *
+ * Unlike std::list (a node per element) or std::deque (a block per few elements, allocated and freed as the
+ * queue moves), a SlabQueue only allocates when it outgrows its slab, doubling it, so a queue that has reached
+ * its working size never touches the allocator again. Not thread safe.
+ */
+template <typename T>
+class SlabQueue
+{
+public:
+    explicit SlabQueue(size_t capacity = 64)
+    {
+        size_t size{1};
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        m_slots = std::make_unique<T[]>(size);
+        m_mask = size - 1;
+    }
+    SlabQueue(SlabQueue const&) = delete;
+
+    bool empty() const {return m_head == m_tail;}
+    size_t size() const {return m_tail - m_head;}
+
+    T& front() {return m_slots[m_head & m_mask];}
+    T& back() {return m_slots[(m_tail - 1) & m_mask];}
+
+    void push_back(T&& value)
+    {
+        if (size() == m_mask + 1)
+        {
+            Grow();
+        }
+        m_slots[m_tail++ & m_mask] = std::move(value);
+    }
+
+    void pop_front()
+    {
+        m_slots[m_head++ & m_mask] = T{};
+    }
+
+    void pop_back()
+    {
+        m_slots[--m_tail & m_mask] = T{};
+    }
+
+private:
+    void Grow()
+    {
+        auto size = (m_mask + 1) * 2;
+        auto slots = std::make_unique<T[]>(size);
+        for (auto idx=m_head; idx != m_tail; ++idx)
+        {
+            slots[idx - m_head] = std::move(m_slots[idx & m_mask]);
+        }
+        m_tail -= m_head;
+        m_head = 0;
+        m_slots = std::move(slots);
+        m_mask = size - 1;
+    }
+
+    std::unique_ptr<T[]> m_slots;
+    size_t m_mask;
+    size_t m_head{0}; //index of the front element, only ever grows (wraps through m_mask)
+    size_t m_tail{0}; //one past the back element
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * A move-only, type erased void() callable with inline storage, used in place of std::function for pool work.
+ *
+ * Callables up to InlineSize bytes (a lambda capturing a few pointers and integers, a std::bind of a member
+ * function, even a std::function) live inside the Task itself, so making, queueing and running one allocates
+ * nothing. Bigger callables, or ones that could throw while being moved, fall back to the heap.
+ * sizeof(Task) is one cache line.
+ */
+class Task
+{
+public:
+    static constexpr size_t InlineSize{48};
+
+    Task() = default;
+    Task(std::nullptr_t) {}
+    Task(Task const&) = delete;
+    Task& operator=(Task const&) = delete;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task> && !std::is_same_v<std::decay_t<F>, std::nullptr_t>>>
+    Task(F&& func)
+    {
+        using Func = std::decay_t<F>;
+        if constexpr (IsInline<Func>())
+        {
+            new (&m_storage) Func(std::forward<F>(func));
+            m_ops = &InlineOps<Func>;
+        }
+        else
+        {
+            *reinterpret_cast<Func**>(&m_storage) = new Func(std::forward<F>(func));
+            m_ops = &HeapOps<Func>;
+        }
+    }
+
+    Task(Task&& ref) noexcept
+    {
+        MoveFrom(ref);
+    }
+
+    Task& operator=(Task&& ref) noexcept
+    {
+        if (this != &ref)
+        {
+            Reset();
+            MoveFrom(ref);
+        }
+        return *this;
+    }
+
+    Task& operator=(std::nullptr_t) noexcept
+    {
+        Reset();
+        return *this;
+    }
+
+    ~Task()
+    {
+        Reset();
+    }
+
+    void operator()()
+    {
+        m_ops->m_invoke(&m_storage);
+    }
+
+    explicit operator bool() const {return m_ops != nullptr;}
+    friend bool operator==(Task const& lhs, std::nullptr_t) {return !lhs;}
+    friend bool operator!=(Task const& lhs, std::nullptr_t) {return static_cast<bool>(lhs);}
+
+private:
+    struct Ops
+    {
+        void (*m_invoke)(void* storage);
+        void (*m_move)(void* dest, void* src); //move construct dest from src, then destroy src
+        void (*m_destroy)(void* storage);
+    };
+
+    template <typename Func>
+    static constexpr bool IsInline()
+    {
+        return sizeof(Func) <= InlineSize && alignof(Func) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible_v<Func>;
+    }
+
+    template <typename Func>
+    static constexpr Ops InlineOps{
+        [](void* storage) {(*static_cast<Func*>(storage))();},
+        [](void* dest, void* src) {new (dest) Func(std::move(*static_cast<Func*>(src))); static_cast<Func*>(src)->~Func();},
+        [](void* storage) {static_cast<Func*>(storage)->~Func();}
+    };
+
+    template <typename Func>
+    static constexpr Ops HeapOps{
+        [](void* storage) {(**static_cast<Func**>(storage))();},
+        [](void* dest, void* src) {*static_cast<Func**>(dest) = *static_cast<Func**>(src);},
+        [](void* storage) {delete *static_cast<Func**>(storage);}
+    };
+
+    void MoveFrom(Task& ref) noexcept
+    {
+        if (ref.m_ops)
+        {
+            ref.m_ops->m_move(&m_storage, &ref.m_storage);
+            m_ops = ref.m_ops;
+            ref.m_ops = nullptr;
+        }
+    }
+
+    void Reset() noexcept
+    {
+        if (m_ops)
+        {
+            m_ops->m_destroy(&m_storage);
+            m_ops = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char m_storage[InlineSize];
+    Ops const* m_ops{nullptr}; //nullptr when empty
+};
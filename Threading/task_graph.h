@@ -0,0 +1,193 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <initializer_list>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+#include "task.h"
+#include "future.h"
+
+/**
+ * A static graph of tasks and the dependencies between them, built once and run on a pool any number of times.
+ *
+ * There is no barrier between stages: each node counts its unfinished dependencies, and the worker that
+ * finishes a node's last dependency queues that node itself. Queued from a worker, it lands on that worker's
+ * own deque, so the consumer usually runs on the core that just produced its input.
+ *
+ *     TaskGraph graph;
+ *     auto load = graph.Add([&]{...});
+ *     auto left = graph.Add([&]{...}, {load});
+ *     auto right = graph.Add([&]{...}, {load});
+ *     graph.Add([&]{...}, {left, right});
+ *     graph.Run(pool).Get();
+ *
+ * The graph must not be changed, and must outlive the run, until the future from Run is ready.
+ */
+class TaskGraph
+{
+public:
+    using NodeId = size_t;
+
+    TaskGraph() = default;
+    TaskGraph(TaskGraph const&) = delete;
+
+    /**
+     * Add a node running func once everything in dependsOn has finished
+     */
+    template <typename F>
+    NodeId Add(F&& func, std::initializer_list<NodeId> dependsOn = {})
+    {
+        m_nodes.push_back(std::make_unique<Node>(std::forward<F>(func)));
+        auto id = m_nodes.size() - 1;
+        for (auto dep: dependsOn)
+        {
+            Precede(dep, id);
+        }
+        return id;
+    }
+
+    /**
+     * after won't start until before has finished
+     */
+    void Precede(NodeId before, NodeId after)
+    {
+        if (before >= m_nodes.size() || after >= m_nodes.size())
+        {
+            throw std::out_of_range("TaskGraph node does not exist");
+        }
+        m_nodes[before]->m_successors.push_back(after);
+        ++m_nodes[after]->m_dependencies;
+    }
+
+    size_t Size() const {return m_nodes.size();}
+
+    /**
+     * Queue every node without dependencies and return a future that is ready once all nodes have run. If a node
+     * throws, the rest of the graph still runs and the future carries the first exception.
+     */
+    template <typename Pool>
+    Future<void> Run(Pool& pool)
+    {
+        CheckAcyclic();
+
+        auto run = std::make_shared<RunState>(m_nodes.size(), Executor{pool});
+        auto result = run->m_promise.GetFuture();
+        if (m_nodes.empty())
+        {
+            run->m_promise.SetValue();
+            return result;
+        }
+
+        for (auto& node: m_nodes)
+        {
+            node->m_pending.store(node->m_dependencies, std::memory_order_relaxed);
+        }
+        for (auto id=0U; id < m_nodes.size(); ++id)
+        {
+            if (m_nodes[id]->m_dependencies == 0)
+            {
+                pool.AddWork([this, &pool, run, id]{Execute(pool, run, id);});
+            }
+        }
+        return result;
+    }
+
+private:
+    struct Node
+    {
+        template <typename F>
+        explicit Node(F&& func) : m_work{std::forward<F>(func)} {}
+
+        Task m_work;
+        std::vector<NodeId> m_successors;
+        size_t m_dependencies{0}; //fixed once the graph is built
+        std::atomic<size_t> m_pending{0}; //dependencies still running in the current Run
+    };
+
+    struct RunState
+    {
+        RunState(size_t nodes, Executor executor) : m_remaining{nodes}, m_promise{executor} {}
+        std::atomic<size_t> m_remaining; //nodes that haven't finished
+        std::atomic<bool> m_failed{false};
+        std::exception_ptr m_error; //written once, by whoever set m_failed
+        Promise<void> m_promise;
+    };
+
+    template <typename Pool>
+    void Execute(Pool& pool, std::shared_ptr<RunState> const& run, NodeId id)
+    {
+        Node& node = *m_nodes[id];
+        try
+        {
+            node.m_work();
+        }
+        catch (...)
+        {
+            if (!run->m_failed.exchange(true))
+            {
+                run->m_error = std::current_exception();
+            }
+        }
+
+        for (auto next: node.m_successors)
+        {
+            if (m_nodes[next]->m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                pool.AddWork([this, &pool, run, next]{Execute(pool, run, next);});
+            }
+        }
+
+        if (run->m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            if (run->m_failed)
+            {
+                run->m_promise.SetError(run->m_error);
+            }
+            else
+            {
+                run->m_promise.SetValue();
+            }
+        }
+    }
+
+    /**
+     * Kahn's algorithm, a graph with a cycle would never finish
+     */
+    void CheckAcyclic() const
+    {
+        std::vector<size_t> pending(m_nodes.size());
+        std::vector<NodeId> ready;
+        for (auto id=0U; id < m_nodes.size(); ++id)
+        {
+            pending[id] = m_nodes[id]->m_dependencies;
+            if (pending[id] == 0)
+            {
+                ready.push_back(id);
+            }
+        }
+        size_t visited{0};
+        while (!ready.empty())
+        {
+            auto id = ready.back();
+            ready.pop_back();
+            ++visited;
+            for (auto next: m_nodes[id]->m_successors)
+            {
+                if (--pending[next] == 0)
+                {
+                    ready.push_back(next);
+                }
+            }
+        }
+        if (visited != m_nodes.size())
+        {
+            throw std::logic_error("TaskGraph contains a cycle");
+        }
+    }
+
+    std::vector<std::unique_ptr<Node>> m_nodes;
+};
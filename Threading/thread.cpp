@@ -10,109 +10,13 @@
 #include <string>
 #include <iomanip>
 #include <algorithm>
+#include <numeric>
+#include <vector>
 
-/**
- * A simple thread pool using std::thread and mutex/condition for synchronization
- */
-class ThreadPool
-{
-public:
-    using WorkFunction = std::function<void()>;
-
-    ThreadPool(size_t maxThreads) : m_maxThreads{maxThreads}
-    {
-    }
-    ThreadPool() = delete;
-    ThreadPool(ThreadPool const&) = delete;
-
-    void AddWork(WorkFunction work)
-    {
-        {
-            std::lock_guard<std::mutex> guard{m_mutex};
-            m_workList.push_back(work);
-        }
-        m_cond.notify_all();
-    }
-
-    void Start()
-    {
-        std::lock_guard<std::mutex> guard{m_mutex};
-        if (!m_threads.empty())
-        {
-            std::cout << "ThreadPool is already running" << std::endl;
-            return;
-        }
-
-        for (auto count=0; count < m_maxThreads; ++count)
-        {
-            m_threads.push_front(std::thread(std::bind(&ThreadPool::Run, this)));
-        }
-    }
-
-    void Stop()
-    {
-        AddWork(nullptr);
-        auto joinWith=[&](auto& th) {th.join();};
-        std::for_each(std::begin(m_threads), std::end(m_threads), joinWith);
-        std::cout << "Total work " << m_totalWork << std::endl;
-    }
-
-private:
-    void Run() //worker function
-    {
-        size_t threadWork{0};
-        ++m_totalThreads;
-        ++m_availableThreads;
-
-        bool cont{true};
-        while (cont)
-        {
-            WorkFunction cur;
-
-            { //critical section
-                std::unique_lock<std::mutex> guard{m_mutex};
-                while (m_workList.empty())
-                {
-                    m_cond.wait(guard);
-                }
-                if (m_workList.empty())
-                {
-                    continue;
-                }
-
-                cur = m_workList.front();
-                if (cur == nullptr)
-                {
-                    cont = false;
-                    continue;
-                }
-                m_workList.pop_front();
-            }
-
-            --m_availableThreads;
-            cur();
-            ++m_availableThreads;
-            ++threadWork;
-            ++m_totalWork;
-        }
-        --m_totalThreads;
-        --m_availableThreads;
-
-        std::ostringstream msg;
-        msg << "Thread Exiting, total work for this thread is " << threadWork << std::endl;
-        std::cout << msg.str();
-    }
-
-private:
-    size_t m_maxThreads;
-    std::list<std::thread> m_threads;
-    std::mutex  m_mutex;
-    std::list<WorkFunction> m_workList;
-    std::condition_variable m_cond;
-    std::atomic<size_t> m_availableThreads{0};
-    std::atomic<size_t> m_totalThreads{0};
-    std::atomic<size_t> m_totalWork{0};
-};
+#include "thread_pool.h"
+#include "primality.h"
+#include "factor.h"
+#include "result_sink.h"
 
 uint32_t factorial(uint32_t val)
 {
@@ -127,64 +31,52 @@ uint32_t factorial(uint32_t val)
 }
 
 /**
- * A class for testing and storing prime numbers
+ * A class for testing and storing prime numbers. Every thread keeps the primes it finds to itself (see
+ * result_sink.h), they only come together, sorted, in GetPrimes.
  */
 class FactorPrimes
 {
 public:
     FactorPrimes() = default;
     FactorPrimes(FactorPrimes const&) = delete;
-    void CheckPrime(uint32_t val)
+    void CheckPrime(uint64_t val)
     {
         //check if prime
         if (IsPrime(val))
         {
-            //if prime, add it to the list
-            std::lock_guard<std::mutex> guard(m_mutex);
-            m_primes.push_back(val);
+            //if prime, add it to this thread's buffer
+            m_primes.Add(val);
         }
     }
 
     /**
-     * This algorithm is not important for the example, except that it provides heavy computational 
-     * load
+     * Trial division by small primes, then deterministic Miller-Rabin (see primality.h)
      */
-    bool IsPrime(uint32_t val)
+    bool IsPrime(uint64_t val)
     {
-        if (val == 0 || val == 1)
-        {
-            return false;
-        }
-
-        for (auto count=2; count <= val/2; ++count)
-        {
-            if (val % count == 0)
-            {
-                return false;
-            }
-        }
-        return true;
+        return Primality::IsPrime(val);
     }
 
-    std::list<uint32_t> GetPrimes() const 
+    /**
+     * Every prime found, in order. Call it once the checking is done.
+     */
+    std::vector<uint64_t> GetPrimes() const
     {
-        std::lock_guard<std::mutex> guard(m_mutex);
-        return m_primes;
+        return m_primes.Merge();
     }
 private:
-    mutable std::mutex m_mutex;
-    std::list<uint32_t> m_primes;
+    ResultSink<uint64_t> m_primes;
 };
 
 /**
- * A simple main that takes 2 arguments (exactly). The first is the number of threads, the second is the maximum value
- *
+ * A simple main that takes 2 arguments, the number of threads and the maximum value, and lists the primes up to it.
+ * With "factor" as a third argument it lists the factorization of every value instead.
  */
 int main(int argc, char* argv[])
 {
-    if (argc != 3)
+    if (argc != 3 && !(argc == 4 && std::string{argv[3]} == "factor"))
     {
-        std::cout << "Give me number of threads and a maximum range" << std::endl;
+        std::cout << "Give me number of threads and a maximum range, and optionally factor" << std::endl;
         return -1;
     }
 
@@ -195,17 +87,39 @@ int main(int argc, char* argv[])
 
     pool.Start();
 
-    FactorPrimes factor;
-
-    for (auto count=1; count <= maxValue; ++count)
+    if (argc == 4)
     {
-        pool.AddWork(std::bind(&FactorPrimes::CheckPrime, &factor, count));
+        std::vector<uint64_t> values(maxValue);
+        std::iota(values.begin(), values.end(), 1);
+        auto factors = Factorizer::FactorAll(values, pool);
+        pool.Stop();
+        std::cout << pool.Stats();
+        for (auto idx=0U; idx < values.size(); ++idx)
+        {
+            std::cout << "|" << std::setw(16) << values[idx] << " | ";
+            char const* separator = "";
+            for (auto& [prime, exponent]: factors[idx])
+            {
+                std::cout << separator << prime;
+                separator = " * ";
+                if (exponent > 1)
+                {
+                    std::cout << "^" << exponent;
+                }
+            }
+            std::cout << std::endl;
+        }
+        return 0;
     }
 
+    FactorPrimes factor;
+    pool.ParallelFor(1, maxValue+1, 0, [&](size_t value){factor.CheckPrime(value);});
+
     pool.Stop();
+    std::cout << pool.Stats();
     auto primes{factor.GetPrimes()};
     std::cout << "Prime numbers from 0 - " << maxValue << std::endl;
     std::for_each(primes.begin(), primes.end(), [](auto& val){std::cout << "|" << std::setw(16) << val << " | " << std::endl;});
-    std::cout << factor.GetPrimes().size() << " primes found from 0 - " << maxValue << std::endl;
+    std::cout << primes.size() << " primes found from 0 - " << maxValue << std::endl;
     return 0;
 }
@@ -0,0 +1,815 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <list>
+#include <vector>
+#include <memory>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <array>
+
+#include "task.h"
+#include "slab_queue.h"
+#include "future.h"
+#include "pool_stats.h"
+#include "topology.h"
+#include "priority.h"
+
+/**
+ * A simple thread pool using std::thread and mutex/condition for synchronization
+ *
+ * Two scheduling modes are available:
+ *  - SharedQueue: every worker pulls from a single mutex protected list, and every AddWork wakes all workers
+ *  - WorkStealing: every worker owns a deque. The owner pushes and pops at the back (LIFO), idle workers steal
+ *    from the front (FIFO) of the other deques. Work added from outside the pool is distributed round-robin,
+ *    and idle workers park on a condition and are woken one at a time.
+ *
+ * Stats() returns per worker telemetry (see pool_stats.h) at any time.
+ *
+ * A PlacementPolicy (see topology.h) pins the workers to CPUs. Each pinned worker then rebuilds its own
+ * queue and counters, so the OS's first-touch policy puts them in the memory of the worker's NUMA node. Thieves
+ * try the workers on their own node before crossing to another one.
+ *
+ * Every queue has one lane per Priority, and workers serve the highest lane with work anywhere in the pool before
+ * a lower one. So that a steady stream of high priority work can't starve the rest, work that has waited longer
+ * than the starvation limit on a lower lane is taken first. Each worker guards its own deque (the shared queue
+ * is guarded by whoever pops from it). Stats() reports the queue latency of every lane.
+ */
+class ThreadPool
+{
+public:
+    using WorkFunction = Task;
+
+    enum class Scheduling
+    {
+        SharedQueue,
+        WorkStealing
+    };
+
+    /**
+     * A pool asked for no threads gets one, so there is always a worker for the round-robin to hand work to
+     */
+    ThreadPool(size_t maxThreads, Scheduling scheduling = Scheduling::WorkStealing, PlacementPolicy placement = {})
+        : m_maxThreads{std::max<size_t>(maxThreads, 1)}
+        , m_scheduling{scheduling}
+        , m_pinned{placement.m_kind != PlacementPolicy::Kind::None}
+        , m_placement{PlaceWorkers(placement, m_maxThreads)}
+        , m_localWorkers(m_maxThreads)
+    {
+        for (auto count=0U; count < m_maxThreads; ++count)
+        {
+            m_workers.push_back(std::make_unique<Worker>());
+            m_workers.back()->m_index = count;
+            m_workers.back()->m_node = m_placement[count].m_node;
+        }
+
+        //steal from the workers on our own node first, each list starts just after the thief
+        for (auto thief=0U; thief < m_maxThreads; ++thief)
+        {
+            auto& victims = m_workers[thief]->m_victims;
+            for (auto sameNode : {true, false})
+            {
+                for (auto offset=1U; offset < m_maxThreads; ++offset)
+                {
+                    auto victim = (thief + offset) % m_maxThreads;
+                    if ((m_placement[victim].m_node == m_placement[thief].m_node) == sameNode)
+                    {
+                        victims.push_back(victim);
+                    }
+                }
+            }
+        }
+    }
+    ThreadPool() = delete;
+    ThreadPool(ThreadPool const&) = delete;
+
+    /**
+     * Queue any void() callable on the lane for priority. It is moved straight into the queue, and stored inline
+     * when it is small.
+     */
+    template <typename F>
+    void AddWork(F&& func, Priority priority = Priority::Normal)
+    {
+        auto lane = LaneOf(priority);
+        QueuedWork work{WorkFunction{std::forward<F>(func)}, ReadTicks(), lane};
+        if (m_scheduling == Scheduling::SharedQueue)
+        {
+            {
+                auto guard = LockCounted(m_mutex, Counters());
+                m_workList[lane].push_back(std::move(work));
+                ++m_laneQueued[lane];
+                UpdateMax(m_queueHighWater, SharedDepth());
+            }
+            m_cond.notify_all();
+            return;
+        }
+
+        //work submitted by one of our own workers stays local, everything else is spread round-robin
+        Worker& target = (t_pool == this) ? *t_worker : *m_workers[m_nextWorker++ % m_workers.size()];
+
+        ++m_outstanding;
+        {
+            auto guard = LockCounted(target.m_mutex, Counters());
+            target.m_work[lane].push_back(std::move(work));
+            ++m_laneQueued[lane];
+        }
+        UpdateMax(m_queueHighWater, ++m_queued);
+        WakeOne();
+    }
+
+    /**
+     * Queue func and return a Future for its result: pool.AddWork(useFuture, [] {return 42;}).Then(...)
+     */
+    template <typename F>
+    auto AddWork(UseFuture, F&& func, Priority priority = Priority::Normal)
+    {
+        using Result = std::invoke_result_t<std::decay_t<F>&>;
+        Promise<Result> promise{Executor{*this}};
+        auto future = promise.GetFuture();
+        AddWork([state = future.State(), func = std::forward<F>(func)]() mutable {state->SetFrom(func);}, priority);
+        return future;
+    }
+
+    /**
+     * How long work may wait on a lower lane while higher lanes are served before it is taken ahead of them
+     */
+    void SetStarvationLimit(std::chrono::nanoseconds limit)
+    {
+        m_starvationNs = limit.count();
+    }
+
+    void Start()
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+        if (!m_threads.empty())
+        {
+            std::cout << "ThreadPool is already running" << std::endl;
+            return;
+        }
+
+        for (auto count=0U; count < m_maxThreads; ++count)
+        {
+            if (m_scheduling == Scheduling::SharedQueue)
+            {
+                m_threads.push_front(std::thread(std::bind(&ThreadPool::Run, this, count)));
+            }
+            else
+            {
+                m_threads.push_front(std::thread(std::bind(&ThreadPool::RunStealing, this, count)));
+            }
+        }
+
+        if (m_pinned)
+        {
+            //swap in the Worker each thread built on its own node, nobody touches m_workers until we release them
+            std::unique_lock<std::mutex> startGuard{m_startMutex};
+            m_startCond.wait(startGuard, [&]{return m_startedWorkers == m_maxThreads;});
+            for (auto count=0U; count < m_maxThreads; ++count)
+            {
+                auto& old = *m_workers[count];
+                auto& local = *m_localWorkers[count];
+                for (auto lane=0U; lane < PriorityLanes; ++lane)
+                {
+                    while (!old.m_work[lane].empty())
+                    {
+                        local.m_work[lane].push_back(std::move(old.m_work[lane].front()));
+                        old.m_work[lane].pop_front();
+                    }
+                }
+                m_workers[count] = std::move(m_localWorkers[count]);
+            }
+            m_released = true;
+            m_startCond.notify_all();
+        }
+    }
+
+    /**
+     * The CPUs (empty for unpinned) and NUMA node each worker was given by the PlacementPolicy
+     */
+    std::vector<WorkerPlacement> const& Placement() const {return m_placement;}
+
+    size_t Threads() const {return m_maxThreads;}
+
+    void Stop()
+    {
+        if (m_scheduling == Scheduling::SharedQueue)
+        {
+            std::lock_guard<std::mutex> guard{m_mutex};
+            m_stopping = true;
+            m_cond.notify_all();
+        }
+        else
+        {
+            std::lock_guard<std::mutex> guard{m_parkMutex};
+            m_stopping = true;
+            m_parkCond.notify_all();
+        }
+        auto joinWith=[&](auto& th) {th.join();};
+        std::for_each(std::begin(m_threads), std::end(m_threads), joinWith);
+        std::cout << "Total work " << m_totalWork << std::endl;
+    }
+
+    /**
+     * A snapshot of the pool's telemetry. Cheap enough to poll while the pool is busy.
+     */
+    PoolStats Stats() const
+    {
+        auto nsPerTick = m_calibration.NsPerTick();
+        PoolStats stats;
+        for (auto& cur: m_workers)
+        {
+            stats.m_workers.emplace_back(cur->m_counters, nsPerTick);
+        }
+        stats.m_external = WorkerStats{m_externalCounters, nsPerTick};
+        if (m_scheduling == Scheduling::SharedQueue)
+        {
+            std::lock_guard<std::mutex> guard{m_mutex};
+            stats.m_queueDepth = SharedDepth();
+        }
+        else
+        {
+            stats.m_queueDepth = m_queued;
+        }
+        stats.m_queueHighWater = m_queueHighWater;
+        return stats;
+    }
+
+    /**
+     * Submit the range [begin, end) as a handful of chunked tasks that call body(index) for every index, and return
+     * without waiting for them. grain is the smallest number of indices a chunk is split down to, 0 lets the chunks
+     * size themselves from the measured cost of body.
+     *
+     * Chunks split lazily: while it runs, a chunk hands the upper half of what it has left back to the pool, but
+     * only when a worker is idle. A cheap, uniform range costs a few tasks, and a skewed one still balances.
+     */
+    template <typename Body>
+    void AddBulk(size_t begin, size_t end, size_t grain, Body body, Priority priority = Priority::Normal)
+    {
+        if (begin >= end)
+        {
+            return;
+        }
+        SubmitBulk(std::make_shared<BulkState<Body>>(std::move(body), grain, end - begin, priority), begin, end);
+    }
+
+    /**
+     * As AddBulk, but return once body has run for the whole range. The calling thread runs queued work while it
+     * waits, and a worker of this pool never blocks here, so ParallelFor may be nested inside pool work.
+     */
+    template <typename Body>
+    void ParallelFor(size_t begin, size_t end, size_t grain, Body body, Priority priority = Priority::Normal)
+    {
+        if (begin >= end)
+        {
+            return;
+        }
+        auto state = std::make_shared<BulkState<Body>>(std::move(body), grain, end - begin, priority);
+        SubmitBulk(state, begin, end);
+        while (state->m_remaining != 0)
+        {
+            if (RunOne())
+            {
+                continue;
+            }
+            if (t_pool == this)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> guard{state->m_mutex};
+            state->m_done.wait(guard, [&]{return state->m_remaining == 0;});
+        }
+    }
+
+    /**
+     * Run one piece of queued work on the calling thread. Returns false if there was nothing to run.
+     */
+    bool RunOne()
+    {
+        QueuedWork cur;
+        if (m_scheduling == Scheduling::SharedQueue)
+        {
+            {
+                auto guard = LockCounted(m_mutex, Counters());
+                if (SharedDepth() == 0)
+                {
+                    return false;
+                }
+                PopShared(cur);
+            }
+            Record(cur, Counters());
+            ++m_totalWork;
+            return true;
+        }
+
+        if (!Take(cur))
+        {
+            return false;
+        }
+        Execute(cur);
+        return true;
+    }
+
+private:
+    static constexpr size_t InitialChunksPerThread{4}; //how many chunks AddBulk starts with per worker
+    static constexpr auto TargetStepTime = std::chrono::microseconds{20}; //automatic grain aims for this much work
+    static constexpr auto DefaultStarvationLimit = std::chrono::milliseconds{10};
+
+    using Clock = std::chrono::steady_clock;
+
+    template <typename Body>
+    struct BulkState
+    {
+        BulkState(Body body, size_t grain, size_t count, Priority priority)
+            : m_body{std::move(body)}, m_grain{grain}, m_priority{priority}, m_remaining{count}
+        {
+        }
+        Body m_body;
+        size_t m_grain; //0 for automatic
+        Priority m_priority; //every chunk, split or not, goes on this lane
+        std::atomic<size_t> m_remaining; //indices that haven't been processed yet
+        std::mutex m_mutex;
+        std::condition_variable m_done; //signalled when m_remaining reaches 0
+    };
+
+    template <typename Body>
+    void SubmitBulk(std::shared_ptr<BulkState<Body>> const& state, size_t begin, size_t end)
+    {
+        auto count = end - begin;
+        auto minChunk = std::max<size_t>(state->m_grain, 1);
+        auto chunks = std::min((count + minChunk - 1) / minChunk, std::max<size_t>(m_maxThreads, 1) * InitialChunksPerThread);
+        auto lo = begin;
+        for (auto chunk=0U; chunk < chunks; ++chunk)
+        {
+            auto hi = lo + count / chunks + (chunk < count % chunks ? 1 : 0);
+            AddWork([this, state, lo, hi]{RunChunk(state, lo, hi);}, state->m_priority);
+            lo = hi;
+        }
+    }
+
+    template <typename Body>
+    void RunChunk(std::shared_ptr<BulkState<Body>> const& state, size_t lo, size_t hi)
+    {
+        auto step = std::max<size_t>(state->m_grain, 1);
+        size_t done{0};
+        while (lo < hi)
+        {
+            if (done != 0 && HigherWaiting(state->m_priority))
+            {
+                //give the worker up between steps, the rest of the chunk queues behind the more urgent work
+                AddWork([this, state, lo, hi]{RunChunk(state, lo, hi);}, state->m_priority);
+                break;
+            }
+            if (hi - lo >= 2 * step && Hungry())
+            {
+                auto mid = lo + (hi - lo) / 2;
+                AddWork([this, state, mid, hi]{RunChunk(state, mid, hi);}, state->m_priority);
+                hi = mid;
+            }
+
+            auto stop = std::min(hi, lo + step);
+            done += stop - lo;
+            if (state->m_grain != 0)
+            {
+                for (; lo < stop; ++lo)
+                {
+                    state->m_body(lo);
+                }
+                continue;
+            }
+
+            //automatic grain, grow or shrink the step so each one takes about TargetStepTime
+            auto start = Clock::now();
+            for (; lo < stop; ++lo)
+            {
+                state->m_body(lo);
+            }
+            auto elapsed = Clock::now() - start;
+            if (elapsed < TargetStepTime / 2)
+            {
+                step *= 2;
+            }
+            else if (elapsed > TargetStepTime * 2 && step > 1)
+            {
+                step /= 2;
+            }
+        }
+
+        if (state->m_remaining.fetch_sub(done) == done)
+        {
+            std::lock_guard<std::mutex> guard{state->m_mutex};
+            state->m_done.notify_all();
+        }
+    }
+
+    /**
+     * True when a worker is looking for work and there is none queued, i.e. splitting a chunk now would pay off
+     */
+    bool Hungry() const
+    {
+        if (m_scheduling == Scheduling::SharedQueue)
+        {
+            return m_availableThreads != 0;
+        }
+        return m_sleeping != 0 && m_queued == 0;
+    }
+
+    /**
+     * True when work on a lane above priority's is queued
+     */
+    bool HigherWaiting(Priority priority) const
+    {
+        for (auto lane=0U; lane < LaneOf(priority); ++lane)
+        {
+            if (m_laneQueued[lane] != 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * A queued WorkFunction and when it was queued
+     */
+    struct QueuedWork
+    {
+        WorkFunction m_work;
+        uint64_t m_enqueued{0}; //ReadTicks() at AddWork
+        size_t m_lane{LaneOf(Priority::Normal)};
+    };
+
+    /**
+     * Per worker state. The deque is only used by the work stealing scheduler. Aligned so neighbouring workers don't
+     * share a cache line.
+     */
+    struct alignas(64) Worker
+    {
+        size_t m_index{0}; //position in m_workers
+        unsigned m_node{0}; //NUMA node we were placed on
+        std::vector<size_t> m_victims; //who to steal from, nearest first
+        std::mutex m_mutex; //guards m_work, contended only by thieves
+        std::array<SlabQueue<QueuedWork>, PriorityLanes> m_work; //one per lane, owner uses the back, thieves the front
+        WorkerCounters m_counters;
+    };
+
+    /**
+     * The calling thread's counters, worker threads have their own, everybody else shares one set
+     */
+    WorkerCounters& Counters()
+    {
+        return (t_pool == this) ? t_worker->m_counters : m_externalCounters;
+    }
+
+    /**
+     * Run cur, recording its queue wait and run time
+     */
+    static void Record(QueuedWork& cur, WorkerCounters& counters)
+    {
+        auto start = ReadTicks();
+        counters.m_wait[cur.m_lane].Record(start - cur.m_enqueued);
+        cur.m_work();
+        counters.m_run.Record(ReadTicks() - start);
+        counters.m_tasks.Add(1);
+    }
+
+    /**
+     * Set up the calling thread as worker index: pin it and, when pinned, rebuild its Worker on the local node
+     */
+    void Enter(size_t index)
+    {
+        if (!PinCurrentThread(m_placement[index].m_cpus))
+        {
+            std::ostringstream msg;
+            msg << "Unable to pin worker " << index << ", it will run unpinned" << std::endl;
+            std::cout << msg.str();
+        }
+
+        if (m_pinned)
+        {
+            auto local = std::make_unique<Worker>();
+            local->m_index = index;
+            local->m_node = m_workers[index]->m_node;
+            local->m_victims = m_workers[index]->m_victims;
+
+            std::unique_lock<std::mutex> startGuard{m_startMutex};
+            m_localWorkers[index] = std::move(local);
+            ++m_startedWorkers;
+            m_startCond.notify_all();
+            m_startCond.wait(startGuard, [&]{return m_released;});
+        }
+
+        t_pool = this;
+        t_worker = m_workers[index].get();
+        t_workerCounters = &t_worker->m_counters;
+    }
+
+    void Run(size_t index) //worker function
+    {
+        Enter(index);
+
+        size_t threadWork{0};
+        ++m_totalThreads;
+        ++m_availableThreads;
+
+        bool cont{true};
+        while (cont)
+        {
+            QueuedWork cur;
+
+            { //critical section
+                auto guard = LockCounted(m_mutex, t_worker->m_counters);
+                if (SharedDepth() == 0)
+                {
+                    auto idleStart = ReadTicks();
+                    while (SharedDepth() == 0 && !m_stopping)
+                    {
+                        m_cond.wait(guard);
+                    }
+                    t_worker->m_counters.m_idleTicks.Add(ReadTicks() - idleStart);
+                }
+
+                if (SharedDepth() == 0)
+                {
+                    //stopping, and everything queued has been taken
+                    cont = false;
+                    continue;
+                }
+                PopShared(cur);
+            }
+
+            --m_availableThreads;
+            Record(cur, t_worker->m_counters);
+            ++m_availableThreads;
+            ++threadWork;
+            ++m_totalWork;
+        }
+        --m_totalThreads;
+        --m_availableThreads;
+
+        std::ostringstream msg;
+        msg << "Thread Exiting, total work for this thread is " << threadWork << std::endl;
+        std::cout << msg.str();
+    }
+
+    void RunStealing(size_t index) //worker function for the work stealing scheduler
+    {
+        Enter(index);
+
+        size_t threadWork{0};
+        ++m_totalThreads;
+        ++m_availableThreads;
+
+        while (true)
+        {
+            QueuedWork cur;
+            if (Take(cur))
+            {
+                --m_availableThreads;
+                Execute(cur);
+                ++m_availableThreads;
+                ++threadWork;
+                continue;
+            }
+
+            if (!Park())
+            {
+                break;
+            }
+        }
+        --m_totalThreads;
+        --m_availableThreads;
+
+        std::ostringstream msg;
+        msg << "Thread Exiting, total work for this thread is " << threadWork << std::endl;
+        std::cout << msg.str();
+    }
+
+    void Execute(QueuedWork& cur)
+    {
+        Record(cur, Counters());
+        ++m_totalWork;
+        if (--m_outstanding == 0 && m_stopping)
+        {
+            //last piece of work after Stop, release anybody still parked
+            std::lock_guard<std::mutex> guard{m_parkMutex};
+            m_parkCond.notify_all();
+        }
+    }
+
+    /**
+     * The total queued in the shared queue, m_mutex must be held
+     */
+    size_t SharedDepth() const
+    {
+        size_t depth{0};
+        for (auto& lane: m_workList)
+        {
+            depth += lane.size();
+        }
+        return depth;
+    }
+
+    /**
+     * Take the next piece of work from the shared queue, which must not be empty, m_mutex must be held
+     */
+    void PopShared(QueuedWork& out)
+    {
+        auto lane = 0U;
+        while (m_workList[lane].empty())
+        {
+            ++lane;
+        }
+        for (auto low = PriorityLanes - 1; low > lane; --low)
+        {
+            if (!m_workList[low].empty() && Starving(m_workList[low].front()))
+            {
+                lane = low;
+                break;
+            }
+        }
+        out = std::move(m_workList[lane].front());
+        m_workList[lane].pop_front();
+        --m_laneQueued[lane];
+    }
+
+    /**
+     * True if work has waited longer than the starvation limit
+     */
+    bool Starving(QueuedWork const& work) const
+    {
+        return (ReadTicks() - work.m_enqueued) * m_calibration.NsPerTick() > m_starvationNs.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Find the next piece of work for the calling thread: the highest lane with work anywhere, from our own deque
+     * if we have some on that lane, otherwise stolen
+     */
+    bool Take(QueuedWork& out)
+    {
+        for (auto lane=0U; lane < PriorityLanes; ++lane)
+        {
+            if (m_laneQueued[lane] == 0)
+            {
+                continue;
+            }
+            if ((t_pool == this && PopLocal(*t_worker, lane, out)) || Steal(lane, out))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Pop the newest work on lane from our own deque, unless work on a lower lane is starving, then that goes first
+     */
+    bool PopLocal(Worker& self, size_t lane, QueuedWork& out)
+    {
+        auto guard = LockCounted(self.m_mutex, self.m_counters);
+        for (auto low = PriorityLanes - 1; low > lane; --low)
+        {
+            if (!self.m_work[low].empty() && Starving(self.m_work[low].front()))
+            {
+                out = std::move(self.m_work[low].front());
+                self.m_work[low].pop_front();
+                Dequeued(low);
+                return true;
+            }
+        }
+        if (self.m_work[lane].empty())
+        {
+            return false;
+        }
+        out = std::move(self.m_work[lane].back());
+        self.m_work[lane].pop_back();
+        Dequeued(lane);
+        return true;
+    }
+
+    bool Steal(size_t lane, QueuedWork& out)
+    {
+        auto& counters = Counters();
+        if (t_pool == this)
+        {
+            for (auto victim: t_worker->m_victims)
+            {
+                if (TakeFront(*m_workers[victim], lane, out, counters))
+                {
+                    counters.m_steals.Add(1);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        //a thread from outside the pool has no deque or node, just visit everybody
+        auto first = m_nextWorker++;
+        for (auto offset=0U; offset < m_workers.size(); ++offset)
+        {
+            if (TakeFront(*m_workers[(first + offset) % m_workers.size()], lane, out, counters))
+            {
+                counters.m_steals.Add(1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool TakeFront(Worker& victim, size_t lane, QueuedWork& out, WorkerCounters& counters)
+    {
+        auto guard = LockCounted(victim.m_mutex, counters);
+        if (victim.m_work[lane].empty())
+        {
+            return false;
+        }
+        out = std::move(victim.m_work[lane].front());
+        victim.m_work[lane].pop_front();
+        Dequeued(lane);
+        return true;
+    }
+
+    /**
+     * Count out work taken from lane of a deque, the deque's lock must be held
+     */
+    void Dequeued(size_t lane)
+    {
+        --m_laneQueued[lane];
+        --m_queued;
+    }
+
+    /**
+     * Sleep until there is something queued. Returns false once the pool is stopping and all work is done.
+     *
+     * m_sleeping is raised before m_queued is checked, and AddWork raises m_queued before checking m_sleeping,
+     * so at least one side always sees the other and a wakeup can't be lost.
+     */
+    bool Park()
+    {
+        auto idleStart = ReadTicks();
+        std::unique_lock<std::mutex> guard{m_parkMutex};
+        ++m_sleeping;
+        while (m_queued == 0 && !(m_stopping && m_outstanding == 0))
+        {
+            m_parkCond.wait(guard);
+        }
+        --m_sleeping;
+        t_worker->m_counters.m_idleTicks.Add(ReadTicks() - idleStart);
+        return !(m_stopping && m_outstanding == 0 && m_queued == 0);
+    }
+
+    void WakeOne()
+    {
+        if (m_sleeping != 0)
+        {
+            std::lock_guard<std::mutex> guard{m_parkMutex};
+            m_parkCond.notify_one();
+        }
+    }
+
+private:
+    size_t m_maxThreads;
+    Scheduling m_scheduling;
+    std::list<std::thread> m_threads;
+    mutable std::mutex  m_mutex;
+    std::array<SlabQueue<QueuedWork>, PriorityLanes> m_workList; //one per lane
+    std::condition_variable m_cond;
+    std::atomic<size_t> m_availableThreads{0};
+    std::atomic<size_t> m_totalThreads{0};
+    std::atomic<size_t> m_totalWork{0};
+
+    //work stealing state
+    std::vector<std::unique_ptr<Worker>> m_workers; //one deque per worker
+    std::atomic<size_t> m_nextWorker{0}; //round-robin cursor for work added from outside the pool
+    std::atomic<size_t> m_queued{0}; //work sitting in a deque
+    std::array<std::atomic<size_t>, PriorityLanes> m_laneQueued{}; //queued per lane, changed under the queue's lock
+    std::atomic<size_t> m_outstanding{0}; //work queued or running
+    std::atomic<size_t> m_sleeping{0}; //workers parked in Park()
+    std::mutex m_parkMutex;
+    std::condition_variable m_parkCond;
+    std::atomic<bool> m_stopping{false}; //only raised while holding m_parkMutex (m_mutex for SharedQueue)
+    std::atomic<int64_t> m_starvationNs{std::chrono::nanoseconds{DefaultStarvationLimit}.count()};
+
+    //placement
+    bool m_pinned; //workers are pinned and rebuild their Worker on their own node
+    std::vector<WorkerPlacement> m_placement; //one per worker
+    std::vector<std::unique_ptr<Worker>> m_localWorkers; //built by the pinned workers, swapped in by Start
+    std::mutex m_startMutex;
+    std::condition_variable m_startCond;
+    size_t m_startedWorkers{0}; //guarded by m_startMutex
+    bool m_released{false}; //guarded by m_startMutex
+
+    //telemetry
+    WorkerCounters m_externalCounters; //pool work run by threads that aren't workers
+    std::atomic<size_t> m_queueHighWater{0};
+    TickCalibration m_calibration;
+
+    inline static thread_local ThreadPool* t_pool{nullptr}; //the pool the calling thread works for, if any
+    inline static thread_local Worker* t_worker{nullptr}; //the calling worker's deque
+};
@@ -0,0 +1,369 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include <tuple>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/**
+ * One logical CPU and where it sits in the machine
+ */
+struct CpuInfo
+{
+    unsigned m_cpu{0}; //logical CPU number, as the kernel numbers them
+    unsigned m_node{0}; //NUMA node
+    unsigned m_package{0}; //socket
+    unsigned m_core{0}; //core id within the package, hyperthread siblings share it
+};
+
+/**
+ * Parse a kernel style CPU list ("0-3,8,10-11")
+ */
+inline std::vector<unsigned> ParseCpuList(std::string const& list)
+{
+    std::vector<unsigned> cpus;
+    std::istringstream in{list};
+    std::string range;
+    while (std::getline(in, range, ','))
+    {
+        range.erase(std::remove_if(range.begin(), range.end(), [](char ch){return ch == ' ' || ch == '\n';}), range.end());
+        if (range.empty())
+        {
+            continue;
+        }
+        auto dash = range.find('-');
+        auto first = std::stoul(range.substr(0, dash));
+        auto last = (dash == std::string::npos) ? first : std::stoul(range.substr(dash + 1));
+        for (auto cpu=first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+/**
+ * The CPUs we may run on, grouped by NUMA node, socket and core
+ */
+class CpuTopology
+{
+public:
+    CpuTopology() = default;
+
+    /**
+     * Read the topology of this machine from sysfs (sysfsRoot is only changed to point at a captured copy).
+     * CPUs outside the process' affinity mask are left out. Without NUMA information everything is node 0.
+     */
+    static CpuTopology Detect(std::string const& sysfsRoot = "/sys/devices/system")
+    {
+        CpuTopology topology;
+        auto online = ParseCpuList(ReadFile(sysfsRoot + "/cpu/online"));
+        auto allowed = AllowedCpus();
+        for (auto cpu: online)
+        {
+            if (!allowed.empty() && std::find(allowed.begin(), allowed.end(), cpu) == allowed.end())
+            {
+                continue;
+            }
+            auto base = sysfsRoot + "/cpu/cpu" + std::to_string(cpu) + "/topology/";
+            CpuInfo info;
+            info.m_cpu = cpu;
+            info.m_package = ReadNumber(base + "physical_package_id");
+            info.m_core = ReadNumber(base + "core_id");
+            topology.m_cpus.push_back(info);
+        }
+
+        for (auto node: ParseCpuList(ReadFile(sysfsRoot + "/node/online")))
+        {
+            for (auto cpu: ParseCpuList(ReadFile(sysfsRoot + "/node/node" + std::to_string(node) + "/cpulist")))
+            {
+                for (auto& info: topology.m_cpus)
+                {
+                    if (info.m_cpu == cpu)
+                    {
+                        info.m_node = node;
+                    }
+                }
+            }
+        }
+        topology.Finish();
+        return topology;
+    }
+
+    /**
+     * Build a made up topology, so placement can be exercised on any box. Nodes are separated by ';', each is a CPU
+     * list optionally followed by "@<threads per core>", e.g. "0-7@2;8-15@2" is two sockets of four two-way SMT
+     * cores. Consecutive CPUs in a node's list share a core, and every node is its own socket.
+     */
+    static CpuTopology FromDescription(std::string const& description)
+    {
+        CpuTopology topology;
+        std::istringstream in{description};
+        std::string nodeDesc;
+        unsigned node{0};
+        while (std::getline(in, nodeDesc, ';'))
+        {
+            auto at = nodeDesc.find('@');
+            auto threadsPerCore = (at == std::string::npos) ? 1U : static_cast<unsigned>(std::stoul(nodeDesc.substr(at + 1)));
+            auto cpus = ParseCpuList(nodeDesc.substr(0, at));
+            for (auto idx=0U; idx < cpus.size(); ++idx)
+            {
+                topology.m_cpus.push_back(CpuInfo{cpus[idx], node, node, idx / std::max(threadsPerCore, 1U)});
+            }
+            ++node;
+        }
+        topology.Finish();
+        return topology;
+    }
+
+    std::vector<CpuInfo> const& Cpus() const {return m_cpus;}
+    size_t Nodes() const {return m_nodes;}
+
+    /**
+     * The node a CPU belongs to, 0 if we don't know the CPU
+     */
+    unsigned NodeOf(unsigned cpu) const
+    {
+        for (auto& info: m_cpus)
+        {
+            if (info.m_cpu == cpu)
+            {
+                return info.m_node;
+            }
+        }
+        return 0;
+    }
+
+    std::vector<unsigned> CpusOfNode(unsigned node) const
+    {
+        std::vector<unsigned> cpus;
+        for (auto& info: m_cpus)
+        {
+            if (info.m_node == node)
+            {
+                cpus.push_back(info.m_cpu);
+            }
+        }
+        return cpus;
+    }
+
+private:
+    static std::string ReadFile(std::string const& path)
+    {
+        std::ifstream in{path};
+        std::string content;
+        std::getline(in, content);
+        return content;
+    }
+
+    static unsigned ReadNumber(std::string const& path)
+    {
+        auto content = ReadFile(path);
+        return content.empty() ? 0 : static_cast<unsigned>(std::stoul(content));
+    }
+
+    static std::vector<unsigned> AllowedCpus()
+    {
+        std::vector<unsigned> cpus;
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0)
+        {
+            for (auto cpu=0U; cpu < CPU_SETSIZE; ++cpu)
+            {
+                if (CPU_ISSET(cpu, &set))
+                {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+#endif
+        return cpus;
+    }
+
+    void Finish()
+    {
+        std::sort(m_cpus.begin(), m_cpus.end(), [](auto const& lhs, auto const& rhs) {
+            return std::tie(lhs.m_node, lhs.m_package, lhs.m_core, lhs.m_cpu) < std::tie(rhs.m_node, rhs.m_package, rhs.m_core, rhs.m_cpu);
+        });
+        m_nodes = 0;
+        for (auto& info: m_cpus)
+        {
+            m_nodes = std::max<size_t>(m_nodes, info.m_node + 1);
+        }
+    }
+
+    std::vector<CpuInfo> m_cpus; //sorted by node, package, core, cpu
+    size_t m_nodes{0};
+};
+
+/**
+ * How a pool places its workers
+ *  - None: leave it to the OS scheduler
+ *  - Compact: fill a core's hyperthreads, then the next core, then the next socket/node
+ *  - Scatter: one worker per node in turn, using every physical core before any hyperthread sibling
+ *  - PerNode: worker i may run anywhere on node i % nodes (a node's memory, not a single CPU)
+ *  - Explicit: worker i runs on m_cpus[i % m_cpus.size()]
+ */
+struct PlacementPolicy
+{
+    enum class Kind
+    {
+        None,
+        Compact,
+        Scatter,
+        PerNode,
+        Explicit
+    };
+
+    Kind m_kind{Kind::None};
+    std::vector<unsigned> m_cpus; //for Explicit
+    CpuTopology m_topology; //left empty to detect the real one
+
+    PlacementPolicy() = default;
+    PlacementPolicy(Kind kind, CpuTopology topology = {}, std::vector<unsigned> cpus = {})
+        : m_kind{kind}
+        , m_cpus{std::move(cpus)}
+        , m_topology{std::move(topology)}
+    {
+    }
+};
+
+/**
+ * Where each worker goes under policy: the CPUs it may use (empty for anywhere) and its NUMA node
+ */
+struct WorkerPlacement
+{
+    std::vector<unsigned> m_cpus;
+    unsigned m_node{0};
+};
+
+inline std::vector<WorkerPlacement> PlaceWorkers(PlacementPolicy const& policy, size_t workers)
+{
+    std::vector<WorkerPlacement> placement(workers);
+    if (policy.m_kind == PlacementPolicy::Kind::None)
+    {
+        return placement;
+    }
+
+    auto topology = policy.m_topology.Cpus().empty() ? CpuTopology::Detect() : policy.m_topology;
+    auto const& cpus = topology.Cpus();
+    if (cpus.empty())
+    {
+        return placement;
+    }
+
+    std::vector<unsigned> order; //CPU for worker i is order[i % size]
+    switch (policy.m_kind)
+    {
+        case PlacementPolicy::Kind::Compact:
+            for (auto& info: cpus)
+            {
+                order.push_back(info.m_cpu);
+            }
+            break;
+
+        case PlacementPolicy::Kind::Scatter:
+        {
+            //per node: the first thread of every core, then the second threads, ...
+            std::vector<std::vector<unsigned>> perNode(topology.Nodes());
+            for (auto node=0U; node < topology.Nodes(); ++node)
+            {
+                std::vector<std::pair<size_t, unsigned>> ranked; //(sibling rank, cpu)
+                for (auto idx=0U; idx < cpus.size(); ++idx)
+                {
+                    if (cpus[idx].m_node != node)
+                    {
+                        continue;
+                    }
+                    size_t rank{0};
+                    while (rank < idx && cpus[idx - rank - 1].m_node == node && cpus[idx - rank - 1].m_package == cpus[idx].m_package &&
+                           cpus[idx - rank - 1].m_core == cpus[idx].m_core)
+                    {
+                        ++rank;
+                    }
+                    ranked.emplace_back(rank, cpus[idx].m_cpu);
+                }
+                std::stable_sort(ranked.begin(), ranked.end(), [](auto const& lhs, auto const& rhs){return lhs.first < rhs.first;});
+                for (auto& cur: ranked)
+                {
+                    perNode[node].push_back(cur.second);
+                }
+            }
+            //then deal round-robin across the nodes
+            for (auto round=0U; order.size() < cpus.size(); ++round)
+            {
+                for (auto& node: perNode)
+                {
+                    if (round < node.size())
+                    {
+                        order.push_back(node[round]);
+                    }
+                }
+            }
+            break;
+        }
+
+        case PlacementPolicy::Kind::PerNode:
+            for (auto worker=0U; worker < workers; ++worker)
+            {
+                auto node = static_cast<unsigned>(worker % topology.Nodes());
+                placement[worker].m_cpus = topology.CpusOfNode(node);
+                placement[worker].m_node = node;
+            }
+            return placement;
+
+        case PlacementPolicy::Kind::Explicit:
+            order = policy.m_cpus;
+            break;
+
+        case PlacementPolicy::Kind::None:
+            break;
+    }
+
+    if (order.empty())
+    {
+        return placement;
+    }
+    for (auto worker=0U; worker < workers; ++worker)
+    {
+        auto cpu = order[worker % order.size()];
+        placement[worker].m_cpus = {cpu};
+        placement[worker].m_node = topology.NodeOf(cpu);
+    }
+    return placement;
+}
+
+/**
+ * Restrict the calling thread to cpus. Returns false if the OS refused (e.g. a CPU that doesn't exist).
+ */
+inline bool PinCurrentThread(std::vector<unsigned> const& cpus)
+{
+    if (cpus.empty())
+    {
+        return true;
+    }
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto cpu: cpus)
+    {
+        if (cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+
+#include "segmented_sieve.h"
+#include "wheel_sieve.h"
+#include "../Threading/thread_pool.h"
+
+/**
+ * A segmented sieve (SegmentedSieve or WheelSieve) spread over a ThreadPool. [0, max] is cut into blocks of whole
+ * windows and every block is sieved by whichever worker picks it up, with its own window buffer and base prime
+ * offsets, so the workers share nothing but the (read only) base primes.
+ */
+template <typename SieveType>
+class ParallelSieve
+{
+public:
+    static constexpr size_t BlocksPerThread{8}; //enough blocks that an unlucky worker doesn't hold everybody up
+    static constexpr size_t OrderedBlocksPerThread{2}; //blocks in flight per thread when primes must come out in order
+
+    ParallelSieve() = delete;
+    ParallelSieve(ParallelSieve const&) = delete;
+    ParallelSieve(SieveType const& sieve, ThreadPool& pool, size_t threads)
+        : m_sieve{sieve}
+        , m_pool{pool}
+        , m_threads{std::max<size_t>(threads, 1)}
+    {
+    }
+
+    /**
+     * The number of primes up to the sieve's max
+     */
+    uint64_t Count()
+    {
+        auto blocks = Blocks(m_threads * BlocksPerThread);
+        std::atomic<uint64_t> total{0};
+        m_pool.ParallelFor(0, blocks.size() - 1, 1, [&](size_t block) {
+            total += m_sieve.CountRange(blocks[block], blocks[block + 1]);
+        });
+        return total;
+    }
+
+    /**
+     * Call onPrime(prime) for every prime up to the sieve's max, in order, on the calling thread. A few blocks are
+     * sieved at a time and buffered until it is their turn, so memory stays bounded.
+     */
+    template <typename F>
+    void ForEachPrime(F&& onPrime)
+    {
+        auto blocks = Blocks(m_threads * BlocksPerThread);
+        auto wave = m_threads * OrderedBlocksPerThread;
+        std::vector<std::vector<uint64_t>> found(wave);
+        for (size_t first=0; first + 1 < blocks.size(); first += wave)
+        {
+            auto last = std::min(first + wave, blocks.size() - 1);
+            m_pool.ParallelFor(first, last, 1, [&](size_t block) {
+                auto& primes = found[block - first];
+                primes.clear();
+                m_sieve.SieveRange(blocks[block], blocks[block + 1], [&](uint64_t prime) {primes.push_back(prime);});
+            });
+            for (auto block=first; block < last; ++block)
+            {
+                for (auto prime: found[block - first])
+                {
+                    onPrime(prime);
+                }
+            }
+        }
+    }
+
+private:
+    /**
+     * Boundaries of about count blocks covering [0, max], each a whole number of windows
+     */
+    std::vector<uint64_t> Blocks(size_t count) const
+    {
+        uint64_t end = m_sieve.Max() + 1;
+        uint64_t window = m_sieve.WindowSpan();
+        auto windows = (end + window - 1) / window;
+        auto perBlock = std::max<uint64_t>((windows + count - 1) / count, 1) * window;
+
+        std::vector<uint64_t> bounds;
+        for (uint64_t low=0; low < end; low += perBlock)
+        {
+            bounds.push_back(low);
+        }
+        bounds.push_back(end);
+        return bounds;
+    }
+
+    SieveType const& m_sieve;
+    ThreadPool& m_pool;
+    size_t m_threads;
+};
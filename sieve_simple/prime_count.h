@@ -0,0 +1,133 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "segmented_sieve.h"
+#include "../Threading/thread_pool.h"
+
+/**
+ * pi(n), the number of primes up to n, without finding them: Lucy_Hedgehog's method, O(n^(3/4)) time and O(sqrt n)
+ * memory.
+ *
+ * S(v) starts as the count of 2..v and, after sieving with each prime p <= sqrt(n), loses the numbers whose smallest
+ * prime factor is p:
+ *
+ *     S(v) -= S(v / p) - S(p - 1)    for every v >= p * p
+ *
+ * Only the values v = n / i are ever needed, and there are about 2 sqrt(n) of them: v <= sqrt(n) are kept in
+ * m_small[v], the rest in m_large[i] for v = n / i.
+ *
+ * Within one prime's round every update reads values from before the round, so the values it reads are copied out
+ * first and the updates themselves can run in parallel.
+ */
+class PrimeCounter
+{
+public:
+    static constexpr size_t ParallelThreshold{1 << 16}; //updates in a round before it is worth going to the pool
+    static constexpr size_t Grain{1 << 12};
+
+    PrimeCounter() = delete;
+    PrimeCounter(PrimeCounter const&) = delete;
+    explicit PrimeCounter(uint64_t n) : m_n{n}, m_root{ISqrt(n)}, m_small(m_root + 1), m_large(m_root + 1)
+    {
+    }
+
+    /**
+     * Count on the calling thread
+     */
+    uint64_t Count()
+    {
+        return Run([](size_t begin, size_t end, auto&& body) {
+            for (auto idx=begin; idx < end; ++idx)
+            {
+                body(idx);
+            }
+        });
+    }
+
+    /**
+     * Count with the big rounds spread over pool
+     */
+    uint64_t Count(ThreadPool& pool)
+    {
+        return Run([&](size_t begin, size_t end, auto&& body) {
+            if (end - begin < ParallelThreshold)
+            {
+                for (auto idx=begin; idx < end; ++idx)
+                {
+                    body(idx);
+                }
+                return;
+            }
+            pool.ParallelFor(begin, end, Grain, body);
+        });
+    }
+
+private:
+    template <typename ForRange>
+    uint64_t Run(ForRange&& forRange)
+    {
+        if (m_n < 2)
+        {
+            return 0;
+        }
+        for (uint64_t v=0; v <= m_root; ++v)
+        {
+            m_small[v] = v == 0 ? 0 : v - 1;
+        }
+        for (uint64_t i=1; i <= m_root; ++i)
+        {
+            m_large[i] = m_n / i - 1;
+        }
+
+        std::vector<uint64_t> before; //the values this round reads, as they were before it
+        for (uint64_t p=2; p <= m_root; ++p)
+        {
+            if (m_small[p] == m_small[p - 1])
+            {
+                continue; //not prime
+            }
+            auto below = m_small[p - 1]; //primes below p
+            auto square = p * p;
+
+            //v = n / i for i <= last still reaches p * p
+            auto last = std::min(m_root, m_n / square);
+            auto inLarge = std::min(last, m_root / p); //i * p <= root reads m_large[i * p], the rest m_small
+            before.resize(inLarge + 1);
+            for (uint64_t i=1; i <= inLarge; ++i)
+            {
+                before[i] = m_large[i * p];
+            }
+            forRange(1, last + 1, [&](size_t i) {
+                auto quotient = i <= inLarge ? before[i] : m_small[m_n / (i * p)];
+                m_large[i] -= quotient - below;
+            });
+
+            if (square <= m_root)
+            {
+                before.assign(m_small.begin(), m_small.begin() + m_root / p + 1);
+                forRange(square, m_root + 1, [&](size_t v) {
+                    m_small[v] -= before[v / p] - below;
+                });
+            }
+        }
+        return m_large[1];
+    }
+
+    uint64_t m_n;
+    uint64_t m_root;
+    std::vector<uint64_t> m_small; //m_small[v] = S(v)
+    std::vector<uint64_t> m_large; //m_large[i] = S(n / i)
+};
+
+inline uint64_t CountPrimes(uint64_t n)
+{
+    return PrimeCounter{n}.Count();
+}
+
+inline uint64_t CountPrimes(uint64_t n, ThreadPool& pool)
+{
+    return PrimeCounter{n}.Count(pool);
+}
@@ -0,0 +1,337 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <numeric>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+#include "wheel_sieve.h"
+#include "prime_table.h"
+
+/**
+ * Prime queries answered from a wheel-30 bitmap (WheelSieve's layout, the same as a PrimeTable file) plus a small
+ * rank/select directory:
+ *  - every SuperBytes of bitmap store the number of primes before them (64 bits)
+ *  - every BlockBytes store the number of primes before them within their superblock (16 bits)
+ *  - every SelectSample-th prime stores the block it falls in
+ *
+ * PrimePi is then a superblock plus a block lookup and a popcount of at most one block, and NthPrime a binary search
+ * over the few blocks between two samples followed by a scan of one block. The directory costs about 3% of the
+ * bitmap.
+ *
+ * Queries above Limit() throw std::out_of_range, the bitmap can't answer them.
+ */
+class PrimeIndex
+{
+public:
+    static constexpr size_t BlockBytes{64};
+    static constexpr size_t SuperBytes{8192}; //small enough that a block's relative rank fits 16 bits
+    static constexpr uint64_t SelectSample{8192};
+
+    PrimeIndex() = delete;
+    PrimeIndex(PrimeIndex const&) = delete;
+    PrimeIndex(PrimeIndex&&) = default;
+
+    /**
+     * Sieve up to limit into memory and index it
+     */
+    explicit PrimeIndex(uint64_t limit)
+        : m_limit{limit}
+        , m_owned(limit / 30 + 1)
+    {
+        WheelSieve sieve{limit};
+        sieve.ForEachWindow(0, 30 * m_owned.size(), [&](uint64_t firstByte, uint8_t const* bits, size_t length) {
+            std::memcpy(m_owned.data() + firstByte, bits, length);
+        });
+        m_owned.back() &= WheelSieve::BitsUpTo(m_owned.size() - 1, limit);
+        m_bits = m_owned.data();
+        m_bytes = m_owned.size();
+        Build();
+    }
+
+    /**
+     * Index a mapped table, which has to outlive the index
+     */
+    explicit PrimeIndex(PrimeTable const& table)
+        : m_limit{table.Limit()}
+        , m_bits{table.Bits()}
+        , m_bytes{table.Bytes()}
+    {
+        Build();
+    }
+
+    uint64_t Limit() const {return m_limit;}
+    uint64_t Count() const {return m_count;}
+    uint64_t BitmapBytes() const {return m_bytes;}
+    uint64_t IndexBytes() const
+    {
+        return m_super.size() * sizeof(m_super[0]) + m_block.size() * sizeof(m_block[0]) + m_select.size() * sizeof(m_select[0]);
+    }
+
+    bool IsPrime(uint64_t value) const
+    {
+        Check(value);
+        if (value < 7)
+        {
+            return value == 2 || value == 3 || value == 5;
+        }
+        return m_bits[value / 30] & WheelSieve::BitsUpTo(value / 30, value) & ~WheelSieve::BitsUpTo(value / 30, value - 1);
+    }
+
+    /**
+     * The number of primes <= value
+     */
+    uint64_t PrimePi(uint64_t value) const
+    {
+        Check(value);
+        auto byte = value / 30;
+        return SmallPrimes(value) + Rank(byte) + __builtin_popcount(m_bits[byte] & WheelSieve::BitsUpTo(byte, value));
+    }
+
+    /**
+     * The nth prime, counting 2 as the first
+     */
+    uint64_t NthPrime(uint64_t nth) const
+    {
+        if (nth == 0 || nth > m_count)
+        {
+            throw std::out_of_range("PrimeIndex: prime " + std::to_string(nth) + " is beyond the limit");
+        }
+        if (nth <= SmallPrimes(m_limit))
+        {
+            return std::array<uint64_t, 3>{2, 3, 5}[nth - 1];
+        }
+        return Select(nth - SmallPrimes(m_limit) - 1);
+    }
+
+    /**
+     * The smallest prime greater than value. Prime gaps are short, so this scans the bitmap rather than ranking.
+     */
+    uint64_t NextPrime(uint64_t value) const
+    {
+        Check(value);
+        for (uint64_t prime: {2, 3, 5})
+        {
+            if (value < prime)
+            {
+                return Check(prime), prime;
+            }
+        }
+        auto byte = value / 30;
+        unsigned bits = m_bits[byte] & ~WheelSieve::BitsUpTo(byte, value);
+        while (bits == 0)
+        {
+            if (++byte == m_bytes)
+            {
+                throw std::out_of_range("PrimeIndex: no prime after " + std::to_string(value) + " within the limit");
+            }
+            bits = m_bits[byte];
+        }
+        return 30 * byte + WheelSieve::Residues[__builtin_ctz(bits)];
+    }
+
+    enum class QueryKind
+    {
+        IsPrime,
+        NextPrime,
+        PrimePi,
+        NthPrime
+    };
+
+    struct Query
+    {
+        QueryKind m_kind;
+        uint64_t m_value;
+        uint64_t m_result{0}; //1 or 0 for IsPrime
+    };
+
+    /**
+     * Answer a batch of queries in place. They are answered in order of the bitmap byte each one starts from rather
+     * than as given, so consecutive lookups walk the bitmap and directory forwards instead of jumping around them.
+     * The order only needs to be roughly right, so it is a single counting sort pass into about one bucket per query.
+     * Batches are limited to 2^32 queries.
+     */
+    void Answer(std::vector<Query>& queries) const
+    {
+        auto startByte = [&](Query const& query) -> uint64_t {
+            if (query.m_kind != QueryKind::NthPrime)
+            {
+                return std::min(query.m_value, m_limit) / 30;
+            }
+            auto rank = query.m_value / SelectSample;
+            return rank < m_select.size() ? m_select[rank] * BlockBytes : 0;
+        };
+
+        unsigned shift{0};
+        while ((m_bytes >> shift) > queries.size())
+        {
+            ++shift;
+        }
+        std::vector<size_t> start((m_bytes >> shift) + 2, 0);
+        for (auto& query: queries)
+        {
+            ++start[(startByte(query) >> shift) + 1];
+        }
+        std::partial_sum(start.begin(), start.end(), start.begin());
+        //a compact copy of the queries in bucket order, so answering them reads one array front to back
+        struct Pending
+        {
+            uint64_t m_value;
+            uint32_t m_idx;
+            QueryKind m_kind;
+        };
+        std::vector<Pending> order(queries.size());
+        for (auto idx=0U; idx < queries.size(); ++idx)
+        {
+            order[start[startByte(queries[idx]) >> shift]++] = Pending{queries[idx].m_value, idx, queries[idx].m_kind};
+        }
+
+        for (auto& cur: order)
+        {
+            uint64_t result{0};
+            switch (cur.m_kind)
+            {
+                case QueryKind::IsPrime: result = IsPrime(cur.m_value) ? 1 : 0; break;
+                case QueryKind::NextPrime: result = NextPrime(cur.m_value); break;
+                case QueryKind::PrimePi: result = PrimePi(cur.m_value); break;
+                case QueryKind::NthPrime: result = NthPrime(cur.m_value); break;
+            }
+            queries[cur.m_idx].m_result = result;
+        }
+    }
+
+private:
+    void Check(uint64_t value) const
+    {
+        if (value > m_limit)
+        {
+            throw std::out_of_range("PrimeIndex: " + std::to_string(value) + " is beyond the limit " + std::to_string(m_limit));
+        }
+    }
+
+    static uint64_t SmallPrimes(uint64_t upTo)
+    {
+        return (upTo >= 2 ? 1 : 0) + (upTo >= 3 ? 1 : 0) + (upTo >= 5 ? 1 : 0);
+    }
+
+    static uint64_t PopCount(uint8_t const* bits, size_t length)
+    {
+        uint64_t count{0};
+        size_t idx{0};
+        for (; idx + 8 <= length; idx += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, bits + idx, sizeof(word));
+            count += __builtin_popcountll(word);
+        }
+        for (; idx < length; ++idx)
+        {
+            count += __builtin_popcount(bits[idx]);
+        }
+        return count;
+    }
+
+    void Build()
+    {
+        auto blocks = (m_bytes + BlockBytes - 1) / BlockBytes;
+        m_block.resize(blocks);
+        m_super.resize((m_bytes + SuperBytes - 1) / SuperBytes);
+        uint64_t rank{0};
+        for (uint64_t block=0; block < blocks; ++block)
+        {
+            auto first = block * BlockBytes;
+            if (first % SuperBytes == 0)
+            {
+                m_super[first / SuperBytes] = rank;
+            }
+            m_block[block] = static_cast<uint16_t>(rank - m_super[first / SuperBytes]);
+            auto ones = PopCount(m_bits + first, std::min<uint64_t>(BlockBytes, m_bytes - first));
+            //sample every prime whose rank is a multiple of SelectSample that lands in this block
+            for (auto sample = (rank + SelectSample - 1) / SelectSample * SelectSample; sample < rank + ones; sample += SelectSample)
+            {
+                m_select.push_back(block);
+            }
+            rank += ones;
+        }
+        m_count = SmallPrimes(m_limit) + rank;
+    }
+
+    uint64_t BlockRank(uint64_t block) const
+    {
+        return m_super[block * BlockBytes / SuperBytes] + m_block[block];
+    }
+
+    /**
+     * Bits set in the bitmap before byte
+     */
+    uint64_t Rank(uint64_t byte) const
+    {
+        auto block = byte / BlockBytes;
+        return BlockRank(block) + PopCount(m_bits + block * BlockBytes, byte % BlockBytes);
+    }
+
+    /**
+     * The number for the set bit of rank rank (from 0)
+     */
+    uint64_t Select(uint64_t rank) const
+    {
+        //the last block starting at or before rank, between the samples either side of it
+        auto sample = rank / SelectSample;
+        auto low = m_select[sample];
+        auto high = sample + 1 < m_select.size() ? m_select[sample + 1] : m_block.size() - 1;
+        while (low < high)
+        {
+            auto mid = low + (high - low + 1) / 2;
+            if (BlockRank(mid) <= rank)
+            {
+                low = mid;
+            }
+            else
+            {
+                high = mid - 1;
+            }
+        }
+
+        auto remaining = rank - BlockRank(low);
+        auto byte = low * BlockBytes;
+        for (; byte + 8 <= m_bytes; byte += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, m_bits + byte, sizeof(word));
+            auto ones = static_cast<uint64_t>(__builtin_popcountll(word));
+            if (ones > remaining)
+            {
+                break;
+            }
+            remaining -= ones;
+        }
+        for (;; ++byte)
+        {
+            auto ones = static_cast<uint64_t>(__builtin_popcount(m_bits[byte]));
+            if (ones > remaining)
+            {
+                break;
+            }
+            remaining -= ones;
+        }
+        unsigned bits = m_bits[byte];
+        for (; remaining != 0; --remaining)
+        {
+            bits &= bits - 1;
+        }
+        return 30 * byte + WheelSieve::Residues[__builtin_ctz(bits)];
+    }
+
+    uint64_t m_limit;
+    std::vector<uint8_t> m_owned; //the bitmap when we sieved it ourselves
+    uint8_t const* m_bits{nullptr};
+    uint64_t m_bytes{0};
+    uint64_t m_count{0};
+    std::vector<uint64_t> m_super; //primes in the bitmap before each superblock
+    std::vector<uint16_t> m_block; //primes in the bitmap before each block, from the start of its superblock
+    std::vector<uint64_t> m_select; //the block holding the bitmap prime of rank i * SelectSample
+};
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+
+/**
+ * An increasing sequence of primes stored as the gaps between them, each a LEB128 varint: one byte for any gap
+ * below 128, which covers every gap below 1.8 * 10^7 and nearly all above. About a byte per prime, against 32 or
+ * so for a std::list node.
+ *
+ * Reading is a forward scan, through ForEachPrime or the iterators, and never copies the store.
+ */
+class PrimeStore
+{
+public:
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = uint64_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = uint64_t const*;
+        using reference = uint64_t const&;
+
+        Iterator() = default;
+
+        reference operator*() const {return m_value;}
+        pointer operator->() const {return &m_value;}
+
+        Iterator& operator++()
+        {
+            if (--m_remaining > 0)
+            {
+                m_value += ReadGap(m_pos);
+            }
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            auto prev = *this;
+            ++*this;
+            return prev;
+        }
+
+        bool operator==(Iterator const& other) const {return m_remaining == other.m_remaining;}
+        bool operator!=(Iterator const& other) const {return m_remaining != other.m_remaining;}
+
+    private:
+        friend class PrimeStore;
+
+        Iterator(uint8_t const* pos, size_t remaining, uint64_t value) : m_pos{pos}, m_remaining{remaining}, m_value{value} {}
+
+        uint8_t const* m_pos{nullptr}; //the gap to the next prime
+        size_t m_remaining{0}; //primes left including this one, 0 at the end
+        uint64_t m_value{0};
+    };
+
+    using iterator = Iterator;
+    using const_iterator = Iterator;
+
+    /**
+     * Append prime, which must be bigger than the last one added
+     */
+    void Add(uint64_t prime)
+    {
+        if (m_count == 0)
+        {
+            m_first = prime;
+        }
+        else
+        {
+            WriteGap(prime - m_last);
+        }
+        m_last = prime;
+        ++m_count;
+    }
+
+    size_t Count() const {return m_count;}
+    size_t size() const {return m_count;}
+    bool empty() const {return m_count == 0;}
+    uint64_t Last() const {return m_last;} //only valid if not empty
+
+    /**
+     * Bytes used by the encoded primes
+     */
+    size_t MemoryBytes() const {return sizeof(*this) + m_gaps.capacity();}
+
+    void ShrinkToFit() {m_gaps.shrink_to_fit();}
+
+    Iterator begin() const
+    {
+        return Iterator{m_gaps.data(), m_count, m_first};
+    }
+
+    Iterator end() const {return Iterator{};}
+
+    /**
+     * Call onPrime(prime) for every prime, in order
+     */
+    template <typename F>
+    void ForEachPrime(F&& onPrime) const
+    {
+        if (m_count == 0)
+        {
+            return;
+        }
+        auto value = m_first;
+        onPrime(value);
+        auto pos = m_gaps.data();
+        auto end = pos + m_gaps.size();
+        while (pos != end)
+        {
+            value += ReadGap(pos);
+            onPrime(value);
+        }
+    }
+
+private:
+    void WriteGap(uint64_t gap)
+    {
+        while (gap >= 0x80)
+        {
+            m_gaps.push_back(static_cast<uint8_t>(gap | 0x80));
+            gap >>= 7;
+        }
+        m_gaps.push_back(static_cast<uint8_t>(gap));
+    }
+
+    static uint64_t ReadGap(uint8_t const*& pos)
+    {
+        uint64_t gap{0};
+        unsigned shift{0};
+        while (*pos & 0x80)
+        {
+            gap |= static_cast<uint64_t>(*pos++ & 0x7F) << shift;
+            shift += 7;
+        }
+        gap |= static_cast<uint64_t>(*pos++) << shift;
+        return gap;
+    }
+
+    std::vector<uint8_t> m_gaps;
+    uint64_t m_first{0};
+    uint64_t m_last{0};
+    size_t m_count{0};
+};
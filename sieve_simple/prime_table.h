@@ -0,0 +1,311 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "wheel_sieve.h"
+
+/**
+ * The header at the start of a prime table file. The bitmap follows at DataOffset, so it is page aligned.
+ */
+struct PrimeTableHeader
+{
+    static constexpr char Magic[8]{'P', 'R', 'I', 'M', 'E', 'T', 'B', 'L'};
+    static constexpr uint32_t CurrentVersion{1};
+    static constexpr uint64_t DataOffset{4096};
+
+    char m_magic[8];
+    uint32_t m_version; //bumped whenever the layout changes
+    uint32_t m_wheel; //numbers per bitmap byte, 30: bit i of byte k is 30k + WheelSieve::Residues[i]
+    uint64_t m_limit; //every prime up to here is in the table, bits above it are clear
+    uint64_t m_bytes; //bitmap length
+    uint64_t m_checksum; //FNV-1a of the bitmap
+};
+
+/**
+ * The wheel-30 bitmap from WheelSieve, stored on disk and mapped read-only.
+ *
+ * Create sieves once and streams the bitmap to the file a window at a time. Open maps it, so a restart is an open()
+ * plus page faults on demand instead of a recompute, and every process that opens the same file shares one copy in
+ * the page cache. OpenOrCreate also extends a table that is too small, copying the old bitmap and sieving only the
+ * numbers above its limit.
+ *
+ * Files are written beside the target and renamed into place, so a reader never sees a half written table and
+ * mappings of the old file stay valid. The header is always checked on open, the checksum only on request since it
+ * means reading the whole bitmap.
+ */
+class PrimeTable
+{
+public:
+    PrimeTable() = default;
+    PrimeTable(PrimeTable const&) = delete;
+    PrimeTable(PrimeTable&& other) noexcept {*this = std::move(other);}
+    PrimeTable& operator=(PrimeTable&& other) noexcept
+    {
+        std::swap(m_map, other.m_map);
+        std::swap(m_mapBytes, other.m_mapBytes);
+        std::swap(m_header, other.m_header);
+        return *this;
+    }
+    ~PrimeTable()
+    {
+        if (m_map)
+        {
+            munmap(m_map, m_mapBytes);
+        }
+    }
+
+    /**
+     * Sieve up to limit, write the table to path and open it
+     */
+    static PrimeTable Create(std::string const& path, uint64_t limit)
+    {
+        Write(path, limit, nullptr);
+        return Open(path);
+    }
+
+    /**
+     * Map the table at path. Throws std::runtime_error if it is missing, isn't a table or has the wrong version.
+     */
+    static PrimeTable Open(std::string const& path, bool verifyChecksum = false)
+    {
+        auto fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Unable to open prime table " + path + ": " + std::strerror(errno));
+        }
+        struct stat info{};
+        fstat(fd, &info);
+        auto size = static_cast<uint64_t>(info.st_size);
+
+        if (size < PrimeTableHeader::DataOffset)
+        {
+            ::close(fd);
+            throw std::runtime_error("Not a prime table (too short): " + path);
+        }
+
+        PrimeTable table;
+        table.m_map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (table.m_map == MAP_FAILED)
+        {
+            table.m_map = nullptr;
+        }
+        ::close(fd);
+        if (!table.m_map)
+        {
+            throw std::runtime_error("Unable to map prime table " + path);
+        }
+        table.m_mapBytes = size;
+        table.m_header = *static_cast<PrimeTableHeader const*>(table.m_map);
+
+        auto const& header = table.m_header;
+        if (std::memcmp(header.m_magic, PrimeTableHeader::Magic, sizeof(header.m_magic)) != 0 ||
+            header.m_version != PrimeTableHeader::CurrentVersion || header.m_wheel != 30 ||
+            header.m_bytes != header.m_limit / 30 + 1 || size < PrimeTableHeader::DataOffset + header.m_bytes)
+        {
+            throw std::runtime_error("Not a prime table (or not this version): " + path);
+        }
+        if (verifyChecksum && Checksum(table.Bits(), header.m_bytes) != header.m_checksum)
+        {
+            throw std::runtime_error("Prime table checksum mismatch: " + path);
+        }
+        return table;
+    }
+
+    /**
+     * Open the table at path if it covers limit. Otherwise build it: from scratch if there is no usable table, by
+     * extending the old one if there is.
+     */
+    static PrimeTable OpenOrCreate(std::string const& path, uint64_t limit)
+    {
+        PrimeTable old;
+        try
+        {
+            old = Open(path);
+        }
+        catch (std::runtime_error const&)
+        {
+            return Create(path, limit);
+        }
+        if (old.Limit() >= limit)
+        {
+            return old;
+        }
+        Write(path, limit, &old);
+        return Open(path);
+    }
+
+    uint64_t Limit() const {return m_header.m_limit;}
+    uint8_t const* Bits() const {return static_cast<uint8_t const*>(m_map) + PrimeTableHeader::DataOffset;}
+    uint64_t Bytes() const {return m_header.m_bytes;}
+
+    /**
+     * Only valid for value <= Limit()
+     */
+    bool IsPrime(uint64_t value) const
+    {
+        if (value < 7)
+        {
+            return value == 2 || value == 3 || value == 5;
+        }
+        auto bit = BitOf(value % 30);
+        return bit >= 0 && (Bits()[value / 30] >> bit) & 1;
+    }
+
+    /**
+     * The number of primes up to min(upTo, Limit())
+     */
+    uint64_t Count(uint64_t upTo = UINT64_MAX) const
+    {
+        upTo = std::min(upTo, Limit());
+        uint64_t count{0};
+        for (uint64_t prime: {2, 3, 5})
+        {
+            count += prime <= upTo ? 1 : 0;
+        }
+        auto bits = Bits();
+        auto full = upTo / 30; //bytes entirely at or below upTo
+        uint64_t idx{0};
+        for (; idx + 8 <= full; idx += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, bits + idx, sizeof(word));
+            count += __builtin_popcountll(word);
+        }
+        for (; idx < full; ++idx)
+        {
+            count += __builtin_popcount(bits[idx]);
+        }
+        count += __builtin_popcount(bits[full] & WheelSieve::BitsUpTo(full, upTo));
+        return count;
+    }
+
+    /**
+     * Call onPrime(prime) for every prime in the table, in order
+     */
+    template <typename F>
+    void ForEachPrime(F&& onPrime) const
+    {
+        for (uint64_t prime: {2, 3, 5})
+        {
+            if (prime <= Limit())
+            {
+                onPrime(prime);
+            }
+        }
+        auto bits = Bits();
+        for (uint64_t idx=0; idx < Bytes(); ++idx)
+        {
+            for (unsigned byte = bits[idx]; byte != 0; byte &= byte - 1)
+            {
+                onPrime(30 * idx + WheelSieve::Residues[__builtin_ctz(byte)]);
+            }
+        }
+    }
+
+private:
+    static int BitOf(uint64_t residue)
+    {
+        static constexpr int8_t bits[30]{-1, 0, -1, -1, -1, -1, -1, 1, -1, -1, -1, 2, -1, 3, -1, -1, -1, 4, -1, 5, -1, -1, -1, 6,
+                                         -1, -1, -1, -1, -1, 7};
+        return bits[residue];
+    }
+
+    static uint64_t Checksum(uint8_t const* data, uint64_t length, uint64_t hash = 14695981039346656037ULL)
+    {
+        for (uint64_t idx=0; idx < length; ++idx)
+        {
+            hash = (hash ^ data[idx]) * 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    /**
+     * Write a table up to limit to path, reusing the bitmap of old (which must be smaller) if given
+     */
+    static void Write(std::string const& path, uint64_t limit, PrimeTable const* old)
+    {
+        auto temp = path + ".tmp." + std::to_string(getpid());
+        auto fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Unable to create prime table " + temp + ": " + std::strerror(errno));
+        }
+        auto fail = [&](std::string const& what) {
+            ::close(fd);
+            ::unlink(temp.c_str());
+            throw std::runtime_error(what + " " + temp + ": " + std::strerror(errno));
+        };
+        auto writeAll = [&](void const* data, size_t length, uint64_t offset) {
+            auto cur = static_cast<char const*>(data);
+            while (length != 0)
+            {
+                auto done = ::pwrite(fd, cur, length, offset);
+                if (done <= 0)
+                {
+                    fail("Unable to write prime table");
+                }
+                cur += done;
+                length -= done;
+                offset += done;
+            }
+        };
+
+        PrimeTableHeader header{};
+        std::memcpy(header.m_magic, PrimeTableHeader::Magic, sizeof(header.m_magic));
+        header.m_version = PrimeTableHeader::CurrentVersion;
+        header.m_wheel = 30;
+        header.m_limit = limit;
+        header.m_bytes = limit / 30 + 1;
+        header.m_checksum = 14695981039346656037ULL;
+
+        //the old table's bytes are final up to the one holding its limit, which may be partly empty
+        uint64_t keep = old ? std::min(old->Bytes() - 1, header.m_bytes) : 0;
+        if (keep != 0)
+        {
+            writeAll(old->Bits(), keep, PrimeTableHeader::DataOffset);
+            header.m_checksum = Checksum(old->Bits(), keep, header.m_checksum);
+        }
+
+        WheelSieve sieve{limit};
+        sieve.ForEachWindow(30 * keep, 30 * header.m_bytes, [&](uint64_t firstByte, uint8_t const* bits, size_t length) {
+            auto isLast = firstByte + length == header.m_bytes;
+            auto body = isLast ? length - 1 : length;
+            writeAll(bits, body, PrimeTableHeader::DataOffset + firstByte);
+            header.m_checksum = Checksum(bits, body, header.m_checksum);
+            if (isLast)
+            {
+                //the last byte runs past limit, and those bits weren't sieved by every prime they need
+                uint8_t byte = bits[body] & WheelSieve::BitsUpTo(header.m_bytes - 1, limit);
+                writeAll(&byte, 1, PrimeTableHeader::DataOffset + header.m_bytes - 1);
+                header.m_checksum = Checksum(&byte, 1, header.m_checksum);
+            }
+        });
+        writeAll(&header, sizeof(header), 0);
+
+        if (::fsync(fd) != 0)
+        {
+            fail("Unable to sync prime table");
+        }
+        ::close(fd);
+        if (::rename(temp.c_str(), path.c_str()) != 0)
+        {
+            ::unlink(temp.c_str());
+            throw std::runtime_error("Unable to rename prime table to " + path + ": " + std::strerror(errno));
+        }
+    }
+
+    void* m_map{nullptr};
+    uint64_t m_mapBytes{0};
+    PrimeTableHeader m_header{};
+};
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+/**
+ * Size in bytes of this CPU's level 1 data or level 2 cache (level is 1 or 2), from sysfs, then sysconf, then a
+ * conservative guess
+ */
+inline size_t DetectCacheBytes(unsigned level)
+{
+    for (auto index=0U; index < 8; ++index)
+    {
+        auto base = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+        std::ifstream levelFile{base + "level"};
+        std::ifstream typeFile{base + "type"};
+        std::ifstream sizeFile{base + "size"};
+        unsigned cacheLevel{0};
+        std::string type;
+        std::string size;
+        if (!(levelFile >> cacheLevel) || !(typeFile >> type) || !(sizeFile >> size) || size.empty())
+        {
+            continue;
+        }
+        if (cacheLevel != level || type == "Instruction")
+        {
+            continue;
+        }
+        size_t bytes = std::stoull(size);
+        switch (size.back())
+        {
+            case 'K': bytes <<= 10; break;
+            case 'M': bytes <<= 20; break;
+            case 'G': bytes <<= 30; break;
+        }
+        return bytes;
+    }
+#if defined(__linux__) && defined(_SC_LEVEL1_DCACHE_SIZE)
+    auto bytes = sysconf(level == 1 ? _SC_LEVEL1_DCACHE_SIZE : _SC_LEVEL2_CACHE_SIZE);
+    if (bytes > 0)
+    {
+        return static_cast<size_t>(bytes);
+    }
+#endif
+    return level == 1 ? 32 * 1024 : 256 * 1024;
+}
+
+/**
+ * The largest r with r * r <= value
+ */
+inline uint64_t ISqrt(uint64_t value)
+{
+    auto root = static_cast<uint64_t>(std::sqrt(static_cast<double>(value)));
+    while (root * root > value)
+    {
+        --root;
+    }
+    while ((root + 1) * (root + 1) <= value)
+    {
+        ++root;
+    }
+    return root;
+}
+
+/**
+ * The odd primes up to limit, the base primes of a segmented sieve
+ */
+inline std::vector<uint32_t> OddPrimesUpTo(uint64_t limit)
+{
+    std::vector<uint32_t> primes;
+    std::vector<bool> composite(limit + 1);
+    for (auto count=3ULL; count <= limit; count += 2)
+    {
+        if (!composite[count])
+        {
+            primes.push_back(static_cast<uint32_t>(count));
+            for (auto idx=count * count; idx <= limit; idx += 2 * count)
+            {
+                composite[idx] = true;
+            }
+        }
+    }
+    return primes;
+}
+
+/**
+ * The sieve of Eratosthenes over [0, max] one cache sized window at a time.
+ *
+ * Only odd numbers are stored, a byte each, so a window of SegmentBytes() bytes covers twice as many numbers. The
+ * odd primes up to sqrt(max) are found first, then every window is crossed off with them, each base prime
+ * remembering where its next multiple falls. Memory is O(sqrt(max)) plus one window, whatever max is, and the
+ * crossing off stays in cache.
+ *
+ * Nothing is stored, primes are handed to a callback in increasing order. Any [low, high) can be sieved on its
+ * own, so disjoint ranges may run on different threads.
+ */
+class SegmentedSieve
+{
+public:
+    SegmentedSieve() = delete;
+    SegmentedSieve(SegmentedSieve const&) = delete;
+
+    /**
+     * segmentBytes of 0 sizes the window to the level 1 data cache, which measured fastest up to 10^10
+     */
+    explicit SegmentedSieve(uint64_t max, size_t segmentBytes = 0)
+        : m_max{max}
+        , m_segmentBytes{segmentBytes != 0 ? segmentBytes : std::clamp<size_t>(DetectCacheBytes(1), 16 * 1024, 1024 * 1024)}
+        , m_basePrimes{OddPrimesUpTo(ISqrt(max))}
+    {
+    }
+
+    uint64_t Max() const {return m_max;}
+    size_t SegmentBytes() const {return m_segmentBytes;}
+    uint64_t WindowSpan() const {return 2 * m_segmentBytes;} //numbers covered by one window
+
+    /**
+     * Call onPrime(prime) for every prime up to Max(), in order
+     */
+    template <typename F>
+    void ForEachPrime(F&& onPrime) const
+    {
+        SieveRange(0, m_max + 1, onPrime);
+    }
+
+    uint64_t Count() const
+    {
+        return CountRange(0, m_max + 1);
+    }
+
+    /**
+     * The number of primes in [low, high)
+     */
+    uint64_t CountRange(uint64_t low, uint64_t high) const
+    {
+        uint64_t count{0};
+        SieveRange(low, high, [&](uint64_t) {++count;});
+        return count;
+    }
+
+    /**
+     * Call onPrime(prime) for every prime in [low, high), in order. high may not exceed Max() + 1.
+     */
+    template <typename F>
+    void SieveRange(uint64_t low, uint64_t high, F&& onPrime) const
+    {
+        if (low <= 2 && high > 2)
+        {
+            onPrime(2);
+        }
+
+        //index i stands for the odd number 2i + 1
+        auto first = low / 2;
+        auto last = high / 2;
+        if (first >= last)
+        {
+            return;
+        }
+
+        //where each base prime's first multiple in the range falls, never below its square
+        std::vector<uint64_t> next(m_basePrimes.size());
+        for (auto idx=0U; idx < m_basePrimes.size(); ++idx)
+        {
+            uint64_t prime = m_basePrimes[idx];
+            auto start = 2 * first + 1;
+            auto multiple = std::max(prime * prime, (start + prime - 1) / prime * prime);
+            if (multiple % 2 == 0)
+            {
+                multiple += prime;
+            }
+            next[idx] = multiple / 2;
+        }
+
+        std::vector<uint8_t> segment(m_segmentBytes);
+        for (auto segLow = first; segLow < last; segLow += m_segmentBytes)
+        {
+            auto segHigh = std::min<uint64_t>(segLow + m_segmentBytes, last);
+            auto length = segHigh - segLow;
+            std::memset(segment.data(), 1, length);
+
+            for (auto idx=0U; idx < m_basePrimes.size(); ++idx)
+            {
+                auto pos = next[idx];
+                if (pos >= segHigh)
+                {
+                    continue;
+                }
+                uint64_t prime = m_basePrimes[idx];
+                for (; pos < segHigh; pos += prime)
+                {
+                    segment[pos - segLow] = 0;
+                }
+                next[idx] = pos;
+            }
+
+            if (segLow == 0)
+            {
+                segment[0] = 0; //1 isn't prime
+            }
+            for (auto idx=0U; idx < length; ++idx)
+            {
+                if (segment[idx])
+                {
+                    onPrime(2 * (segLow + idx) + 1);
+                }
+            }
+        }
+    }
+
+private:
+    uint64_t m_max;
+    size_t m_segmentBytes;
+    std::vector<uint32_t> m_basePrimes; //odd primes up to sqrt(max)
+};
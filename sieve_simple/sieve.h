@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "prime_store.h"
+
+/**
+ * A naive implementation of the seive or Eratosthenes (an algorithm for calculating prime numbers)
+ *
+ */
+class Sieve
+{
+    public:
+        Sieve() = delete; //no Default ctor
+        Sieve(Sieve const&) = delete; //no copy ctor
+        Sieve(uint64_t max)
+        {
+            std::vector<bool> workArea(max+1);
+            //fill the work area with true (treat things as prime until we prove they are not
+            std::fill(workArea.begin(), workArea.end(), true);
+
+            for (auto count=2ULL; count <= max; ++count)
+            {
+                if (workArea[count]) //if so, we have reached a prime
+                {
+                    m_primes.Add(count); //throw it in our store
+                    for (auto idx=count; idx <= max; idx+=count)
+                    {
+                        workArea[idx] = false;
+                    }
+                }
+                //else, skip it
+            }
+            m_primes.ShrinkToFit();
+        }
+
+        PrimeStore const& GetPrimes() const {return m_primes;} //no copy, the store lives as long as the Sieve
+        size_t Count() const {return m_primes.Count();}
+
+        template <typename F>
+        void ForEachPrime(F&& onPrime) const {m_primes.ForEachPrime(onPrime);}
+
+        PrimeStore::Iterator begin() const {return m_primes.begin();}
+        PrimeStore::Iterator end() const {return m_primes.end();}
+    private:
+        PrimeStore m_primes;
+};
@@ -0,0 +1,185 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <random>
+#include <algorithm>
+
+#include "sieve.h"
+#include "segmented_sieve.h"
+#include "wheel_sieve.h"
+#include "parallel_sieve.h"
+#include "prime_count.h"
+#include "prime_index.h"
+#include "../Threading/bench.h"
+
+/**
+ * Times Sieve against SegmentedSieve, WheelSieve and WheelSieve on a ThreadPool at 10^7 up to 10^maxExponent, and
+ * checks they all find the same primes. CountPrimes, which counts without sieving, and building a PrimeIndex are
+ * timed alongside, then the index's queries at the largest size, a sample of each kind checked against the sieve
+ * and the batched answers against the single ones. Results go through bench.h.
+ */
+
+/**
+ * The answers to queries from a single pass of WheelSieve up to max, to check PrimeIndex against. Values have to
+ * be below the last prime up to max, and nth no more than the number of primes.
+ */
+std::vector<uint64_t> SieveAnswers(std::vector<PrimeIndex::Query> const& queries, uint64_t max)
+{
+    //values and nth in increasing order, each resolved once the sieve passes it
+    std::vector<size_t> byValue;
+    std::vector<size_t> byNth;
+    for (auto idx=0U; idx < queries.size(); ++idx)
+    {
+        (queries[idx].m_kind == PrimeIndex::QueryKind::NthPrime ? byNth : byValue).push_back(idx);
+    }
+    auto byKey = [&](size_t lhs, size_t rhs) {return queries[lhs].m_value < queries[rhs].m_value;};
+    std::sort(byValue.begin(), byValue.end(), byKey);
+    std::sort(byNth.begin(), byNth.end(), byKey);
+
+    std::vector<uint64_t> answers(queries.size());
+    auto nextValue = byValue.begin();
+    auto nextNth = byNth.begin();
+    uint64_t count{0};
+    uint64_t last{0};
+    WheelSieve{max}.ForEachPrime([&](uint64_t prime) {
+        //prime is the first prime above these values, count of them are at or below
+        for (; nextValue != byValue.end() && queries[*nextValue].m_value < prime; ++nextValue)
+        {
+            auto const& query = queries[*nextValue];
+            switch (query.m_kind)
+            {
+                case PrimeIndex::QueryKind::IsPrime: answers[*nextValue] = query.m_value == last ? 1 : 0; break;
+                case PrimeIndex::QueryKind::NextPrime: answers[*nextValue] = prime; break;
+                case PrimeIndex::QueryKind::PrimePi: answers[*nextValue] = count; break;
+                case PrimeIndex::QueryKind::NthPrime: break;
+            }
+        }
+        ++count;
+        for (; nextNth != byNth.end() && queries[*nextNth].m_value == count; ++nextNth)
+        {
+            answers[*nextNth] = prime;
+        }
+        last = prime;
+    });
+    return answers;
+}
+
+/**
+ * Takes the largest power of ten to sieve to (default 9) and the largest for the simple Sieve, which needs a bit
+ * per number while it runs (default 8), the threads for the parallel sieve (default one per hardware thread), and
+ * the options in bench.h
+ */
+int main(int argc, char* argv[])
+{
+    BenchSuite suite{"sieve", argc, argv};
+    unsigned maxExponent = suite.Arg(0, 9);
+    unsigned simpleExponent = suite.Arg(1, 8);
+    size_t threads = suite.Arg(2, std::max(1U, std::thread::hardware_concurrency()));
+
+    ThreadPool pool{threads};
+    pool.Start();
+
+    //2 and 3 leave a store of one and two primes, the edge cases of its iterator
+    for (uint64_t max: {2, 3, 4, 30, 10000000})
+    {
+        Sieve simple{max};
+        std::vector<uint64_t> expected;
+        simple.ForEachPrime([&](uint64_t prime) {expected.push_back(prime);});
+        std::vector<uint64_t> iterated{simple.begin(), simple.end()};
+        std::vector<uint64_t> segmented;
+        SegmentedSieve{max}.ForEachPrime([&](uint64_t prime) {segmented.push_back(prime);});
+        WheelSieve wheelSieve{max};
+        std::vector<uint64_t> wheel;
+        wheelSieve.ForEachPrime([&](uint64_t prime) {wheel.push_back(prime);});
+        std::vector<uint64_t> parallel;
+        ParallelSieve{wheelSieve, pool, threads}.ForEachPrime([&](uint64_t prime) {parallel.push_back(prime);});
+        suite.Check(iterated == expected && segmented == expected && wheel == expected && parallel == expected,
+                    "the sieves agree up to " + std::to_string(max));
+    }
+
+    std::cout << "segment bytes " << SegmentedSieve{1}.SegmentBytes() << " (L1d " << DetectCacheBytes(1)
+              << ", L2 " << DetectCacheBytes(2) << "), " << threads << " threads" << std::endl;
+
+    uint64_t max{1};
+    for (auto exponent=1U; exponent <= maxExponent; ++exponent)
+    {
+        max *= 10;
+        if (exponent < 7)
+        {
+            continue;
+        }
+
+        //every case counts the primes up to max, items are the numbers covered
+        auto expected = WheelSieve{max}.Count();
+        auto time = [&](std::string const& name, auto&& count) {
+            auto caseName = name + "/1e" + std::to_string(exponent);
+            uint64_t found{expected};
+            suite.Run(caseName, [&]{found = count();}, max);
+            suite.Check(found == expected, caseName + " found " + std::to_string(found) + " primes, not " + std::to_string(expected));
+        };
+        if (exponent <= simpleExponent)
+        {
+            time("sieve/simple", [&]{return static_cast<uint64_t>(Sieve{max}.Count());});
+        }
+        time("sieve/segmented", [&]{return SegmentedSieve{max}.Count();});
+        time("sieve/wheel", [&]{return WheelSieve{max}.Count();});
+        time("sieve/parallel", [&]{
+            WheelSieve sieve{max};
+            return ParallelSieve{sieve, pool, threads}.Count();
+        });
+        time("count/lucy", [&]{return CountPrimes(max);});
+        time("index/build", [&]{return PrimeIndex{max}.PrimePi(max);});
+    }
+    pool.Stop();
+
+    PrimeIndex index{max};
+    std::cout << "index up to " << max << " uses " << std::setprecision(2) << 100.0 * index.IndexBytes() / index.BitmapBytes()
+              << "% of the bitmap" << std::endl;
+    std::mt19937_64 rng{42};
+    std::vector<PrimeIndex::Query> all; //answered one at a time
+    std::vector<PrimeIndex::Query> sample; //the first of each kind, to check against the sieve
+    char const* names[]{"isprime", "nextprime", "primepi", "nthprime"};
+    for (auto kind: {PrimeIndex::QueryKind::IsPrime, PrimeIndex::QueryKind::PrimePi, PrimeIndex::QueryKind::NthPrime, PrimeIndex::QueryKind::NextPrime})
+    {
+        std::vector<PrimeIndex::Query> queries(100000);
+        for (auto& query: queries)
+        {
+            query.m_kind = kind;
+            query.m_value = kind == PrimeIndex::QueryKind::NthPrime ? 1 + rng() % index.Count() : rng() % (max - 1000);
+        }
+        suite.Run(std::string{"index/"} + names[static_cast<size_t>(kind)], [&]{
+            for (auto& query: queries)
+            {
+                switch (kind)
+                {
+                    case PrimeIndex::QueryKind::IsPrime: query.m_result = index.IsPrime(query.m_value) ? 1 : 0; break;
+                    case PrimeIndex::QueryKind::NextPrime: query.m_result = index.NextPrime(query.m_value); break;
+                    case PrimeIndex::QueryKind::PrimePi: query.m_result = index.PrimePi(query.m_value); break;
+                    case PrimeIndex::QueryKind::NthPrime: query.m_result = index.NthPrime(query.m_value); break;
+                }
+            }
+        }, queries.size());
+        all.insert(all.end(), queries.begin(), queries.end());
+        sample.insert(sample.end(), queries.begin(), queries.begin() + 1000);
+    }
+
+    auto expected = SieveAnswers(sample, max);
+    for (auto idx=0U; idx < sample.size(); ++idx)
+    {
+        auto const& query = sample[idx];
+        suite.Check(query.m_result == expected[idx], std::string{names[static_cast<size_t>(query.m_kind)]} + "(" + std::to_string(query.m_value) +
+                    ") gave " + std::to_string(query.m_result) + ", the sieve " + std::to_string(expected[idx]));
+    }
+
+    auto batched = all;
+    suite.Run("index/batched", [&]{index.Answer(batched);}, batched.size());
+    size_t mismatched{0};
+    for (auto idx=0U; idx < all.size(); ++idx)
+    {
+        mismatched += batched[idx].m_result != all[idx].m_result ? 1 : 0;
+    }
+    suite.Check(mismatched == 0, std::to_string(mismatched) + " batched answers differ from the single ones");
+    return suite.Finish();
+}
@@ -1,55 +1,102 @@
-
 #include <iostream>
 #include <string>
-#include <list>
-#include <vector>
-#include <memory>
+#include <thread>
+#include <stdexcept>
+
+#include "sieve.h"
+#include "segmented_sieve.h"
+#include "wheel_sieve.h"
+#include "parallel_sieve.h"
+#include "prime_count.h"
+#include "prime_table.h"
 
 /**
- * A naive implementation of the seive or Eratosthenes (an algorithm for calculating prime numbers)
- *
+ * Takes the upper limit (default 1000000), optionally the algorithm: wheel (the default), segmented, parallel (the
+ * wheel sieve on a ThreadPool), simple, count (prime counting without a sieve) or parallel-count, and for the
+ * parallel ones the number of threads (default one per hardware thread). Mode table counts from the prime table
+ * file given instead of the threads (default primes.tbl), building or extending it first if it doesn't reach the limit.
  */
-class Sieve
-{
-    public:
-        Sieve() = delete; //no Default ctor
-        Sieve(Sieve const&) = delete; //no copy ctor
-        Sieve(uint64_t max) 
-        {
-            std::vector<bool> workArea(max+1);
-            //fill the work area with true (treat things as prime until we prove they are not
-            std::fill(workArea.begin(), workArea.end(), true);
-
-            for (auto count=2ULL; count <= max; ++count)
-            {
-                if (workArea[count]) //if so, we have reached a prime
-                {
-                    m_primes.push_back(count); //throw it in our list
-                    for (auto idx=count; idx < max; idx+=count)
-                    {
-                        workArea[idx] = false;
-                    }
-                }
-                //else, skip it
-            }
-        }
-
-        std::list<uint64_t> GetPrimes() const {return m_primes;}
-    private:
-        std::list<uint64_t> m_primes;
-};
-
-
 int main(int argc, char* argv[])
 {
     uint64_t upperLimit{1000000};
-    if (argc == 2)
+    std::string mode{"wheel"};
+    if (argc >= 2)
     {
         upperLimit = std::stoull(argv[1]);
     }
-    Sieve sieve{upperLimit};
+    if (argc >= 3)
+    {
+        mode = argv[2];
+    }
+    size_t threads = std::max(1U, std::thread::hardware_concurrency());
+    std::string tablePath{"primes.tbl"};
+    if (argc >= 4)
+    {
+        if (mode == "table")
+        {
+            tablePath = argv[3];
+        }
+        else
+        {
+            threads = std::stoul(argv[3]);
+        }
+    }
+
+    uint64_t found{0};
+    if (mode == "simple")
+    {
+        Sieve sieve{upperLimit};
+        found = sieve.Count();
+    }
+    else if (mode == "segmented")
+    {
+        SegmentedSieve sieve{upperLimit};
+        found = sieve.Count();
+    }
+    else if (mode == "wheel")
+    {
+        WheelSieve sieve{upperLimit};
+        found = sieve.Count();
+    }
+    else if (mode == "parallel")
+    {
+        WheelSieve sieve{upperLimit};
+        ThreadPool pool{threads};
+        pool.Start();
+        found = ParallelSieve{sieve, pool, threads}.Count();
+        pool.Stop();
+    }
+    else if (mode == "count")
+    {
+        found = CountPrimes(upperLimit);
+    }
+    else if (mode == "parallel-count")
+    {
+        ThreadPool pool{threads};
+        pool.Start();
+        found = CountPrimes(upperLimit, pool);
+        pool.Stop();
+    }
+    else if (mode == "table")
+    {
+        try
+        {
+            auto table = PrimeTable::OpenOrCreate(tablePath, upperLimit);
+            found = table.Count(upperLimit);
+        }
+        catch (std::runtime_error const& error)
+        {
+            std::cout << error.what() << std::endl;
+            return -1;
+        }
+    }
+    else
+    {
+        std::cout << "Unknown mode " << mode << ", use wheel, segmented, parallel, simple, count, parallel-count or table" << std::endl;
+        return -1;
+    }
 
-    std::cout << "Found " << sieve.GetPrimes().size() << " from 0 - " << upperLimit << std::endl;
+    std::cout << "Found " << found << " from 0 - " << upperLimit << std::endl;
 
     return 0;
 }